@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "csr_graph.h"
+#include "ranked_adjacency.h"
+
+// Breadth-first tree from a root along one CSR, the tree the BFS visualization draws: every
+// vertex within maxLevels hops, each with the parent that discovered it first. Vertices of
+// the last level are included (the drawing has edges into them) but not expanded.
+struct BfsTree {
+    std::vector<uint32_t> vertices;  // BFS order, root first
+    std::vector<uint32_t> parents;   // parent of vertices[i]; the root is its own parent
+    std::vector<uint32_t> levels;
+    bool timedOut = false;           // cut short by the deadline
+};
+
+// At most limit children per vertex (0: all of them): the first unvisited entries of a
+// best-first row, or with Random a sample drawn with seed, so the same seed gives the same tree.
+struct TreeFanOut {
+    uint32_t limit = 0;
+    ChildRanking ranking = ChildRanking::None;
+    uint64_t seed = 0;
+};
+
+// Reusable per thread: the visited state is stamped with a query epoch.
+class BfsTreeBuilder {
+public:
+    explicit BfsTreeBuilder(const CsrView& graph) : graph_(graph), stamp_(graph.numNodes, 0) {}
+
+    // maxLevels < 0 means no limit
+    BfsTree build(uint32_t root, int maxLevels,
+                  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+        return build(root, maxLevels, graph_, TreeFanOut(), deadline);
+    }
+
+    // Tree along ranked, the rows of the builder's graph in fanOut.ranking order (e.g.
+    // GraphSnapshot::rankedOut). The work per vertex is its children plus the visited papers
+    // skipped on the way, not its degree.
+    BfsTree build(uint32_t root, int maxLevels, const CsrView& ranked, const TreeFanOut& fanOut,
+                  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+        if (++epoch_ == 0) {
+            std::fill(stamp_.begin(), stamp_.end(), 0);
+            epoch_ = 1;
+        }
+        BfsTree tree;
+        tree.vertices.push_back(root);
+        tree.parents.push_back(root);
+        tree.levels.push_back(0);
+        stamp_[root] = epoch_;
+        const bool timed = deadline != std::chrono::steady_clock::time_point::max();
+        const uint32_t limit = fanOut.limit == 0 ? UINT32_MAX : fanOut.limit;
+        std::mt19937_64 rng(fanOut.seed);
+        for (size_t head = 0; head < tree.vertices.size(); ++head) {
+            uint32_t level = tree.levels[head];
+            if (maxLevels >= 0 && level >= static_cast<uint32_t>(maxLevels)) break;
+            if (timed && head % 1024 == 1023 && std::chrono::steady_clock::now() >= deadline) {
+                tree.timedOut = true;
+                break;
+            }
+            uint32_t v = tree.vertices[head];
+            ArrayView<uint32_t> row = ranked.neighborsOf(v);
+            uint32_t taken = 0;
+            auto take = [&](uint32_t u) {
+                if (stamp_[u] == epoch_) return;
+                stamp_[u] = epoch_;
+                tree.vertices.push_back(u);
+                tree.parents.push_back(v);
+                tree.levels.push_back(level + 1);
+                ++taken;
+            };
+            if (fanOut.ranking != ChildRanking::Random) {
+                for (size_t i = 0; i < row.size() && taken < limit; ++i) take(row[i]);
+            } else {
+                // Fisher-Yates over the row without copying it: moved records the swapped slots
+                moved_.clear();
+                auto slot = [&](size_t i) {
+                    auto it = moved_.find(static_cast<uint32_t>(i));
+                    return it == moved_.end() ? static_cast<uint32_t>(i) : it->second;
+                };
+                for (size_t i = 0; i < row.size() && taken < limit; ++i) {
+                    size_t j = i + rng() % (row.size() - i);
+                    uint32_t pick = slot(j);
+                    moved_[static_cast<uint32_t>(j)] = slot(i);
+                    take(row[pick]);
+                }
+            }
+        }
+        return tree;
+    }
+
+private:
+    CsrView graph_;
+    std::vector<uint32_t> stamp_;
+    uint32_t epoch_ = 0;
+    std::unordered_map<uint32_t, uint32_t> moved_;
+};
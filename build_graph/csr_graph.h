@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+
+// Read-only range over contiguous elements (a pre-C++20 std::span).
+template <typename T>
+class ArrayView {
+public:
+    ArrayView() = default;
+    ArrayView(const T* data, size_t size) : data_(data), size_(size) {}
+
+    const T* begin() const { return data_; }
+    const T* end() const { return data_ + size_; }
+    const T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T& operator[](size_t i) const { return data_[i]; }
+
+private:
+    const T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Compressed sparse rows: the neighbors of v are neighbors[offsets[v] .. offsets[v + 1]).
+// Used for out-edges (CSR) as well as in-edges (CSC, the CSR of the reversed graph).
+struct CsrView {
+    const uint64_t* offsets = nullptr;
+    const uint32_t* neighbors = nullptr;
+    uint32_t numNodes = 0;
+
+    uint64_t numEdges() const { return numNodes == 0 ? 0 : offsets[numNodes]; }
+    uint32_t degree(uint32_t v) const { return static_cast<uint32_t>(offsets[v + 1] - offsets[v]); }
+    ArrayView<uint32_t> neighborsOf(uint32_t v) const {
+        return ArrayView<uint32_t>(neighbors + offsets[v], offsets[v + 1] - offsets[v]);
+    }
+};
+
+struct CsrGraph {
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> neighbors;
+
+    uint32_t numNodes() const { return offsets.empty() ? 0 : static_cast<uint32_t>(offsets.size() - 1); }
+    uint64_t numEdges() const { return neighbors.size(); }
+    CsrView view() const { return CsrView{offsets.data(), neighbors.data(), numNodes()}; }
+};
+
+// Builds a CSR with a counting sort on the source; the edges of each source keep their input order.
+inline CsrGraph buildCsr(uint32_t numNodes, const std::vector<std::pair<uint32_t, uint32_t>>& edges) {
+    CsrGraph csr;
+    csr.offsets.assign(static_cast<size_t>(numNodes) + 1, 0);
+    for (const auto& edge : edges) ++csr.offsets[edge.first + 1];
+    for (uint32_t v = 0; v < numNodes; ++v) csr.offsets[v + 1] += csr.offsets[v];
+
+    csr.neighbors.resize(edges.size());
+    std::vector<uint64_t> next(csr.offsets.begin(), csr.offsets.end() - 1);
+    for (const auto& edge : edges) csr.neighbors[next[edge.first]++] = edge.second;
+    return csr;
+}
+
+// CSR of the reversed graph. Rows come out sorted by neighbor id.
+inline CsrGraph transposeCsr(const CsrView& csr) {
+    CsrGraph reversed;
+    reversed.offsets.assign(static_cast<size_t>(csr.numNodes) + 1, 0);
+    for (uint64_t e = 0; e < csr.numEdges(); ++e) ++reversed.offsets[csr.neighbors[e] + 1];
+    for (uint32_t v = 0; v < csr.numNodes; ++v) reversed.offsets[v + 1] += reversed.offsets[v];
+
+    reversed.neighbors.resize(csr.numEdges());
+    std::vector<uint64_t> next(reversed.offsets.begin(), reversed.offsets.end() - 1);
+    for (uint32_t v = 0; v < csr.numNodes; ++v) {
+        for (uint32_t u : csr.neighborsOf(v)) reversed.neighbors[next[u]++] = v;
+    }
+    return reversed;
+}
+
+// Edges packed as (source << 32 | target), so sorting the keys sorts by source, then target.
+inline uint64_t packEdge(uint32_t source, uint32_t target) { return static_cast<uint64_t>(source) << 32 | target; }
+inline uint32_t edgeSource(uint64_t key) { return static_cast<uint32_t>(key >> 32); }
+inline uint32_t edgeTarget(uint64_t key) { return static_cast<uint32_t>(key); }
+
+// Parallel LSD radix sort, one byte per pass. Each thread histograms and scatters its own
+// contiguous block, so every pass is stable. Bytes on which all keys agree are skipped, which
+// for dense vertex ids leaves about 2 * ceil(log256(numNodes)) passes.
+inline void radixSortKeys(std::vector<uint64_t>& keys, unsigned numThreads) {
+    const size_t n = keys.size();
+    if (n < (1u << 16)) {
+        std::sort(keys.begin(), keys.end());
+        return;
+    }
+
+    const size_t numBlocks = std::max<size_t>(1, std::min<size_t>(numThreads, n >> 16));
+    const size_t blockSize = (n + numBlocks - 1) / numBlocks;
+    auto blockRange = [&](size_t block) {
+        return std::make_pair(std::min(n, block * blockSize), std::min(n, (block + 1) * blockSize));
+    };
+
+    std::vector<uint64_t> orBits(numBlocks, 0), andBits(numBlocks, ~uint64_t(0));
+    parallelFor(numBlocks, numThreads, [&](size_t block, unsigned) {
+        auto range = blockRange(block);
+        for (size_t i = range.first; i < range.second; ++i) {
+            orBits[block] |= keys[i];
+            andBits[block] &= keys[i];
+        }
+    });
+    uint64_t allOr = 0, allAnd = ~uint64_t(0);
+    for (size_t block = 0; block < numBlocks; ++block) {
+        allOr |= orBits[block];
+        allAnd &= andBits[block];
+    }
+    uint64_t varying = allOr ^ allAnd;
+
+    std::vector<uint64_t> buffer(n);
+    std::vector<std::array<size_t, 256>> counts(numBlocks);
+    for (unsigned shift = 0; shift < 64; shift += 8) {
+        if (((varying >> shift) & 0xff) == 0) continue;
+
+        parallelFor(numBlocks, numThreads, [&](size_t block, unsigned) {
+            auto range = blockRange(block);
+            counts[block].fill(0);
+            for (size_t i = range.first; i < range.second; ++i) ++counts[block][(keys[i] >> shift) & 0xff];
+        });
+        // Turn the counts into each block's first output position per digit
+        size_t position = 0;
+        for (size_t digit = 0; digit < 256; ++digit) {
+            for (size_t block = 0; block < numBlocks; ++block) {
+                size_t count = counts[block][digit];
+                counts[block][digit] = position;
+                position += count;
+            }
+        }
+        parallelFor(numBlocks, numThreads, [&](size_t block, unsigned) {
+            auto range = blockRange(block);
+            std::array<size_t, 256>& next = counts[block];
+            for (size_t i = range.first; i < range.second; ++i) buffer[next[(keys[i] >> shift) & 0xff]++] = keys[i];
+        });
+        keys.swap(buffer);
+    }
+}
+
+struct EdgeDedupStats {
+    uint64_t inputEdges = 0;
+    uint64_t uniqueEdges = 0;
+    uint64_t duplicateEdges = 0;  // inputEdges - uniqueEdges
+    uint64_t repeatedPairs = 0;   // distinct (source, target) pairs seen more than once
+    uint64_t maxMultiplicity = 0; // most copies of a single pair
+    uint64_t selfLoops = 0;       // unique edges with source == target
+};
+
+// Sorts and deduplicates packed edges in place, then lays them out as a CSR whose rows are
+// sorted by target. Time and memory are linear in the number of edges.
+inline CsrGraph buildCsrFromEdgeKeys(uint32_t numNodes, std::vector<uint64_t>& keys, unsigned numThreads,
+                                     EdgeDedupStats* stats = nullptr) {
+    EdgeDedupStats local;
+    local.inputEdges = keys.size();
+    radixSortKeys(keys, numThreads);
+
+    size_t unique = 0;
+    for (size_t i = 0; i < keys.size();) {
+        size_t j = i + 1;
+        while (j < keys.size() && keys[j] == keys[i]) ++j;
+        uint64_t multiplicity = j - i;
+        if (multiplicity > 1) ++local.repeatedPairs;
+        local.maxMultiplicity = std::max(local.maxMultiplicity, multiplicity);
+        if (edgeSource(keys[i]) == edgeTarget(keys[i])) ++local.selfLoops;
+        keys[unique++] = keys[i];
+        i = j;
+    }
+    keys.resize(unique);
+    local.uniqueEdges = unique;
+    local.duplicateEdges = local.inputEdges - unique;
+    if (stats) *stats = local;
+
+    CsrGraph csr;
+    csr.offsets.assign(static_cast<size_t>(numNodes) + 1, 0);
+    for (uint64_t key : keys) ++csr.offsets[edgeSource(key) + 1];
+    for (uint32_t v = 0; v < numNodes; ++v) csr.offsets[v + 1] += csr.offsets[v];
+
+    csr.neighbors.resize(keys.size());
+    const size_t chunk = 1 << 20;
+    parallelFor((keys.size() + chunk - 1) / chunk, numThreads, [&](size_t task, unsigned) {
+        size_t end = std::min(keys.size(), (task + 1) * chunk);
+        for (size_t i = task * chunk; i < end; ++i) csr.neighbors[i] = edgeTarget(keys[i]);
+    });
+    return csr;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace csv_detail {
+
+// First position in [p, end) holding a, b or c, or end.
+inline const char* findAny(const char* p, const char* end, char a, char b, char c) {
+#if defined(__AVX2__)
+    const __m256i va = _mm256_set1_epi8(a), vb = _mm256_set1_epi8(b), vc = _mm256_set1_epi8(c);
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, va), _mm256_cmpeq_epi8(chunk, vb)),
+                                       _mm256_cmpeq_epi8(chunk, vc));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i wa = _mm_set1_epi8(a), wb = _mm_set1_epi8(b), wc = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, wa), _mm_cmpeq_epi8(chunk, wb)),
+                                    _mm_cmpeq_epi8(chunk, wc));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p) {
+        if (*p == a || *p == b || *p == c) return p;
+    }
+    return end;
+}
+
+} // namespace csv_detail
+
+// Streaming RFC 4180 reader over a writable buffer (e.g. a copy-on-write MappedFile).
+// Fields are string_views into the buffer. Quoted fields may contain separators and
+// newlines; their "" escapes are collapsed in place, so no field is ever copied.
+class CsvReader {
+public:
+    CsvReader(char* data, size_t size, char separator = ',')
+        : pos_(data), end_(data + size), begin_(data), separator_(separator) {}
+
+    // Reads the next record into fields. Returns false once the buffer is exhausted.
+    bool nextRow(std::vector<std::string_view>& fields) {
+        fields.clear();
+        if (pos_ >= end_) return false;
+
+        rowBegin_ = pos_ - begin_;
+        for (;;) {
+            bool rowDone = *pos_ == '"' ? readQuotedField(fields) : readPlainField(fields);
+            if (rowDone) break;
+        }
+        rowEnd_ = pos_ - begin_;
+        return true;
+    }
+
+    // Byte range [rowBegin, rowEnd) of the record last returned, including its line break.
+    size_t rowBegin() const { return rowBegin_; }
+    size_t rowEnd() const { return rowEnd_; }
+
+private:
+    // Consumes the separator or line break after a field; true when the record ended.
+    bool finishField(std::vector<std::string_view>& fields) {
+        if (pos_ >= end_) return true;
+        char c = *pos_++;
+        if (c == separator_) {
+            if (pos_ < end_) return false;
+            fields.emplace_back(pos_, 0); // trailing separator at end of buffer
+            return true;
+        }
+        if (c == '\r' && pos_ < end_ && *pos_ == '\n') ++pos_;
+        return true;
+    }
+
+    bool readPlainField(std::vector<std::string_view>& fields) {
+        const char* stop = csv_detail::findAny(pos_, end_, separator_, '\n', '\r');
+        fields.emplace_back(pos_, stop - pos_);
+        pos_ = const_cast<char*>(stop);
+        return finishField(fields);
+    }
+
+    bool readQuotedField(std::vector<std::string_view>& fields) {
+        char* out = ++pos_;
+        char* fieldStart = out;
+        for (;;) {
+            char* quote = static_cast<char*>(std::memchr(pos_, '"', end_ - pos_));
+            if (!quote) quote = end_;
+            size_t run = quote - pos_;
+            if (out != pos_) std::memmove(out, pos_, run);
+            out += run;
+            if (quote >= end_) {
+                // Unterminated quote: the field runs to the end of the buffer
+                pos_ = end_;
+                break;
+            }
+            if (quote + 1 < end_ && quote[1] == '"') {
+                *out++ = '"';
+                pos_ = quote + 2;
+                continue;
+            }
+            pos_ = quote + 1;
+            break;
+        }
+
+        // Text between the closing quote and the next separator is kept verbatim
+        if (pos_ < end_ && *pos_ != separator_ && *pos_ != '\n' && *pos_ != '\r') {
+            const char* stop = csv_detail::findAny(pos_, end_, separator_, '\n', '\r');
+            size_t run = stop - pos_;
+            std::memmove(out, pos_, run);
+            out += run;
+            pos_ = const_cast<char*>(stop);
+        }
+
+        fields.emplace_back(fieldStart, out - fieldStart);
+        return finishField(fields);
+    }
+
+    char* pos_;
+    char* end_;
+    char* begin_;
+    char separator_;
+    size_t rowBegin_ = 0;
+    size_t rowEnd_ = 0;
+};
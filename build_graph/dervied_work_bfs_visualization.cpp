@@ -1,86 +1,16 @@
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
-#include <queue>
 #include <set>
 
-struct Node {
-    std::string label;
-    int year;
-    int citationCount;
-    double pageRank;
-    std::vector<int> outEdges;
-};
-
-void parseDotFile(const std::string& filename, std::unordered_map<int, Node>& nodes) {
-    std::ifstream infile(filename);
-    std::string line;
-    int lineNumber = 0;
-
-    try {
-        while (std::getline(infile, line)) {
-            ++lineNumber;
-            if (line.find("->") != std::string::npos) {
-                std::stringstream ss(line);
-                int from, to;
-                char ignore;
-                ss >> from >> ignore >> ignore >> to;
-
-                // Ensure both nodes are defined before adding the edge
-                if (nodes.find(from) == nodes.end()) {
-                    std::cerr << "Node " << from << " not found when processing edges." << std::endl;
-                    Node dummyNode;
-                    nodes[from] = dummyNode;
-                }
-                if (nodes.find(to) == nodes.end()) {
-                    std::cerr << "Node " << to << " not found when processing edges." << std::endl;
-                    Node dummyNode;
-                    nodes[to] = dummyNode;
-                }
-
-                nodes[from].outEdges.push_back(to);
-            } else if (line.find("[label=") != std::string::npos) {
-                std::stringstream ss;
-                ss << line;
-                while (line.find("];") == std::string::npos) {
-                    if (!std::getline(infile, line)) {
-                        throw std::runtime_error("Incomplete node definition at end of file.");
-                    }
-                    ss << line;
-                    ++lineNumber;
-                }
-
-                std::string fullLine = ss.str();
-                std::stringstream fullSS(fullLine);
-                int id;
-                fullSS >> id;
-                Node node;
-                size_t labelStart = fullLine.find("label=\"") + 7;
-                size_t labelEnd = fullLine.find("\",", labelStart);
-                node.label = fullLine.substr(labelStart, labelEnd - labelStart);
-
-                size_t yearStart = fullLine.find("year=\"") + 6;
-                size_t yearEnd = fullLine.find("\",", yearStart);
-                node.year = std::stoi(fullLine.substr(yearStart, yearEnd - yearStart));
-
-                size_t citationCountStart = fullLine.find("citationCount=\"") + 15;
-                size_t citationCountEnd = fullLine.find("\"]", citationCountStart);
-                node.citationCount = std::stoi(fullLine.substr(citationCountStart, citationCountEnd - citationCountStart));
-
-                node.pageRank = 1.0;
-                nodes[id] = node;
-            }
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing line " << lineNumber << ": " << line << std::endl;
-        std::cerr << "Exception: " << e.what() << std::endl;
-        exit(EXIT_FAILURE);
-    }
-}
+#include "bfs_tree.h"
+#include "dot_graph_loader.h"
+#include "parallel_bfs.h"
+#include "tree_layout.h"
 
 std::string wrapLabel(const std::string& label, size_t maxWidth) {
     std::stringstream wrappedLabel;
@@ -100,11 +30,15 @@ std::string wrapLabel(const std::string& label, size_t maxWidth) {
     return wrappedLabel.str();
 }
 
-void bfsTree(int start, const std::unordered_map<int, Node>& nodes, int maxLevels, std::ostream& out) {
-    std::unordered_set<int> visited;
-    std::queue<std::pair<int, int>> q; // pair of node and level
-    q.push({start, 0});
-    visited.insert(start);
+// fanOut.limit > 0 keeps only the best (or a seeded random sample of) that many children per paper;
+// ranked holds the references best first, so that is a prefix and the work follows the size of the tree.
+// Full trees (no fan-out limit, often unlimited depth) come from the parallel BFS, which builds the same tree.
+BfsTree buildTree(int start, const GraphSnapshot& graph, int maxLevels, const CsrView& ranked, const TreeFanOut& fanOut) {
+    return fanOut.limit == 0 ? ParallelBfs(graph.out(), graph.in()).build(start, maxLevels)
+                             : BfsTreeBuilder(graph.out()).build(start, maxLevels, ranked, fanOut);
+}
+
+void bfsTree(const BfsTree& tree, int start, const GraphSnapshot& graph, int maxLevels, std::ostream& out) {
 
     std::unordered_map<int, std::vector<int>> levels; // store nodes by levels
     std::set<int> years; // store unique years
@@ -116,21 +50,21 @@ void bfsTree(int start, const std::unordered_map<int, Node>& nodes, int maxLevel
     std::cout << "BFS Tree Structure:" << std::endl;
 
     bool isRoot = true;
-    while (!q.empty()) {
-        int current = q.front().first;
-        int level = q.front().second;
-        q.pop();
+    size_t child = 1; // the children of a paper follow each other in BFS order
+    for (size_t index = 0; index < tree.vertices.size(); ++index) {
+        int current = tree.vertices[index];
+        int level = tree.levels[index];
 
         if (maxLevels != -1 && level >= maxLevels) break;
 
-        levels[nodes.at(current).year].push_back(current);
-        years.insert(nodes.at(current).year);
+        levels[graph.year(current)].push_back(current);
+        years.insert(graph.year(current));
 
         for (int i = 0; i < level; ++i) std::cout << "  ";
-        const Node& node = nodes.at(current);
-        std::cout << current << " (" << node.label << ")" << std::endl;
+        std::string label(graph.title(current));
+        std::cout << current << " (" << label << ")" << std::endl;
 
-        std::string wrappedLabel = wrapLabel(node.label, 20);
+        std::string wrappedLabel = wrapLabel(label, 20);
 
         if (isRoot) {
             out << "  \"" << current << "\" [label=\"" << wrappedLabel << "\", shape=doubleoctagon, style=filled, fillcolor=lightblue];" << std::endl;
@@ -139,12 +73,8 @@ void bfsTree(int start, const std::unordered_map<int, Node>& nodes, int maxLevel
             out << "  \"" << current << "\" [label=\"" << wrappedLabel << "\", shape=box];" << std::endl;
         }
 
-        for (int neighbor : node.outEdges) {
-            if (visited.find(neighbor) == visited.end()) {
-                q.push({neighbor, level + 1});
-                visited.insert(neighbor);
-                out << "  \"" << current << "\" -> \"" << neighbor << "\";" << std::endl;
-            }
+        for (; child < tree.vertices.size() && tree.parents[child] == tree.vertices[index]; ++child) {
+            out << "  \"" << current << "\" -> \"" << tree.vertices[child] << "\";" << std::endl;
         }
     }
 
@@ -163,7 +93,7 @@ void bfsTree(int start, const std::unordered_map<int, Node>& nodes, int maxLevel
 
     // Organize nodes by ranks based on years, skipping the root's year
     for (const auto& level : levels) {
-        if (level.first == nodes.at(start).year) continue; // skip the root's year
+        if (level.first == graph.year(start)) continue; // skip the root's year
         out << "  { rank=same; ";
         out << level.first << "; ";
         for (int node : level.second) {
@@ -177,26 +107,84 @@ void bfsTree(int start, const std::unordered_map<int, Node>& nodes, int maxLevel
 
 int main(int argc, char* argv[]) {
 
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <paper_id> <depth> <dot file name>" << std::endl;
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <paper_id> <depth> <dot or snapshot file name>"
+                  << " [--fan-out=K] [--by=pageRank|citationCount|year|random] [--seed=N] [--format=dot|svg|json]" << std::endl;
         return 1;
     }
 
     int start = std::stoi(argv[1]);
     int maxLevels = std::stoi(argv[2]);
-    std::string dot_filename = argv[3];
+    std::string graph_filename = argv[3];
+    TreeFanOut fanOut;
+    std::string format = "dot";
+    for (int i = 4; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--fan-out=", 0) == 0) {
+            fanOut.limit = static_cast<uint32_t>(std::stoul(arg.substr(10)));
+        } else if (arg.rfind("--by=", 0) == 0) {
+            if (!parseChildRanking(arg.substr(5), fanOut.ranking)) {
+                std::cerr << "Unknown ranking: " << arg.substr(5) << " (pageRank, citationCount, year, random or none)" << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            fanOut.seed = std::stoull(arg.substr(7));
+        } else if (arg == "--format=dot" || arg == "--format=svg" || arg == "--format=json") {
+            format = arg.substr(9);
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
 
-    std::unordered_map<int, Node> nodes;
-    parseDotFile(dot_filename, nodes);
+    // A DOT file only gets the one order of references the trees are cut by
+    DotGraphIndexes indexes;
+    indexes.rankedOut = fanOut.ranking;
+    GraphSnapshot graph;
+    try {
+        graph = openGraph(graph_filename, indexes);
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading graph: " << e.what() << std::endl;
+        return 1;
+    }
+    if (!graph.contains(start)) {
+        std::cerr << "Node id out of range (graph has " << graph.numNodes() << " nodes)" << std::endl;
+        return 1;
+    }
+
+    CsrView ranked = graph.rankedOut(fanOut.ranking == ChildRanking::Random ? ChildRanking::None : fanOut.ranking);
+    if (ranked.numNodes != graph.numNodes()) {
+        std::cerr << "Snapshot has no " << childRankingName(fanOut.ranking) << " order, rebuild it with ./citation_network"
+                  << std::endl;
+        return 1;
+    }
 
     // Create the filename using string concatenation
-    std::string filename = "data/bfs_trees/bfs_tree_" + std::to_string(start) + "_" + std::to_string(maxLevels) + ".dot";
+    std::string filename = "data/bfs_trees/bfs_tree_" + std::to_string(start) + "_" + std::to_string(maxLevels);
+    if (fanOut.limit > 0) {
+        filename += "_top" + std::to_string(fanOut.limit) + "_" + childRankingName(fanOut.ranking);
+        if (fanOut.ranking == ChildRanking::Random) filename += "_" + std::to_string(fanOut.seed);
+    }
+    filename += "." + format;
 
+    BfsTree tree = buildTree(start, graph, maxLevels, ranked, fanOut);
     std::ofstream outfile(filename);
-    bfsTree(start, nodes, maxLevels, outfile);
+    if (format == "dot") {
+        bfsTree(tree, start, graph, maxLevels, outfile);
+    } else {
+        // Laid out here instead of by graphviz: years as layers, few crossings, wrapped titles
+        auto layoutStart = std::chrono::steady_clock::now();
+        TreeLayout layout = layoutTree(tree, graph);
+        double layoutMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - layoutStart).count();
+        if (format == "svg") writeTreeSvg(layout, outfile);
+        else writeTreeJson(layout, outfile);
+        std::cerr << "Laid out " << layout.nodes.size() << " papers on " << layout.years.size() << " year layers ("
+                  << layout.dummies << " bend points, " << layout.crossings << " crossings) in " << layoutMs << " ms" << std::endl;
+    }
     outfile.close();
 
-    std::cout << "BFS tree DOT file has been generated: " << filename << std::endl;
+    std::string formatName = format == "dot" ? "DOT" : format == "svg" ? "SVG" : "JSON";
+    std::cout << "BFS tree " << formatName << " file has been generated: " << filename << std::endl;
 
     return 0;
 }
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "graph_snapshot.h"
+#include "mapped_file.h"
+#include "paper_columns.h"
+#include "paper_id_dictionary.h"
+#include "ranked_adjacency.h"
+
+namespace dot_detail {
+
+// Value of attr="..." in a node definition. The value ends at the first unescaped quote that
+// is followed by ',' or ']', which also keeps labels like ""Cited 12"" intact.
+inline bool attribute(std::string_view definition, std::string_view attr, std::string_view& value) {
+    std::string key = std::string(attr) + "=\"";
+    size_t start = definition.find(key);
+    if (start == std::string_view::npos) return false;
+    start += key.size();
+    for (size_t pos = start; pos < definition.size(); ++pos) {
+        if (definition[pos] != '"' || (pos > start && definition[pos - 1] == '\\')) continue;
+        if (pos + 1 < definition.size() && definition[pos + 1] != ',' && definition[pos + 1] != ']') continue;
+        value = definition.substr(start, pos - start);
+        return true;
+    }
+    value = definition.substr(start);
+    return true;
+}
+
+inline long long leadingInteger(std::string_view text, long long fallback) {
+    std::string digits(text.substr(0, 32));
+    char* end = nullptr;
+    long long value = std::strtoll(digits.c_str(), &end, 10);
+    return end == digits.c_str() ? fallback : value;
+}
+
+inline std::string unescapeQuotes(std::string_view text) {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\\' && i + 1 < text.size() && text[i + 1] == '"') continue;
+        out.push_back(text[i]);
+    }
+    return out;
+}
+
+} // namespace dot_detail
+
+// Indexes a snapshot file carries that a DOT load only builds when the tool asks for them
+struct DotGraphIndexes {
+    bool reachability = false;                    // GraphSnapshot::reachability
+    bool landmarks = false;                       // GraphSnapshot::landmarks
+    bool rankedAdjacency = false;                 // every GraphSnapshot::rankedOut and rankedIn order
+    ChildRanking rankedOut = ChildRanking::None;  // just the rankedOut rows of one order
+};
+
+// Reads a DOT file written by main.cpp (or a pruned copy of one) into an in-memory snapshot,
+// so the query tools can run on either format. DOT node ids become vertex ids; ids that are
+// referenced by an edge but never defined get empty attributes. pageRank defaults to 1.0 for
+// files written before it was added.
+inline GraphSnapshot loadDotGraph(const std::string& filename, const DotGraphIndexes& indexes = DotGraphIndexes()) {
+    struct DotNode {
+        uint32_t id;
+        int year;
+        int citationCount;
+        double pageRank;
+        std::string title;
+        std::string url;
+        std::string paperId;
+        std::string abstract;
+    };
+
+    MappedFile file(filename);
+    file.adviseSequential();
+    const char* p = file.data();
+    const char* end = p + file.size();
+
+    std::vector<DotNode> nodes;
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    uint32_t numNodes = 0;
+    std::string joined;
+
+    while (p < end) {
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* lineEnd = newline ? newline : end;
+        std::string_view line(p, lineEnd - p);
+        p = newline ? newline + 1 : end;
+
+        size_t labelPos = line.find("[label=");
+        if (labelPos != std::string_view::npos) {
+            // A definition runs until the first line containing "];"
+            std::string_view definition = line;
+            if (line.find("];") == std::string_view::npos) {
+                joined.assign(line);
+                while (p < end) {
+                    newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+                    lineEnd = newline ? newline : end;
+                    std::string_view next(p, lineEnd - p);
+                    p = newline ? newline + 1 : end;
+                    joined.append(next);
+                    if (next.find("];") != std::string_view::npos) break;
+                }
+                definition = joined;
+            }
+
+            long long id = dot_detail::leadingInteger(definition, -1);
+            if (id < 0) throw std::runtime_error("Invalid node definition in " + filename + ": " + std::string(line.substr(0, 80)));
+            DotNode node{static_cast<uint32_t>(id), 0, 0, 1.0, "", "", "", ""};
+            std::string_view value;
+            if (dot_detail::attribute(definition, "label", value)) node.title.assign(value);
+            std::string_view rest = definition.substr(std::min(definition.size(), labelPos + 8 + node.title.size()));
+            if (dot_detail::attribute(rest, "year", value)) node.year = static_cast<int>(dot_detail::leadingInteger(value, 0));
+            if (dot_detail::attribute(rest, "citationCount", value)) {
+                node.citationCount = static_cast<int>(dot_detail::leadingInteger(value, 0));
+            }
+            if (dot_detail::attribute(rest, "url", value)) node.url.assign(value);
+            if (dot_detail::attribute(rest, " id", value)) node.paperId.assign(value);
+            if (dot_detail::attribute(rest, "abstract", value)) node.abstract = dot_detail::unescapeQuotes(value);
+            if (dot_detail::attribute(rest, "pageRank", value)) node.pageRank = std::strtod(std::string(value).c_str(), nullptr);
+            numNodes = std::max(numNodes, node.id + 1);
+            nodes.push_back(std::move(node));
+        } else if (line.find("->") != std::string_view::npos) {
+            size_t arrow = line.find("->");
+            long long from = dot_detail::leadingInteger(line, -1);
+            long long to = dot_detail::leadingInteger(line.substr(arrow + 2), -1);
+            if (from < 0 || to < 0) continue;
+            edges.emplace_back(static_cast<uint32_t>(from), static_cast<uint32_t>(to));
+            numNodes = std::max(numNodes, static_cast<uint32_t>(std::max(from, to) + 1));
+        }
+    }
+
+    PaperColumns columns;
+    columns.year.assign(numNodes, 0);
+    columns.citationCount.assign(numNodes, 0);
+    columns.pageRank.assign(numNodes, 1.0);
+    PaperMetadataStore metadata;
+    if (numNodes > 0) metadata.set(numNodes - 1, "", "", "");
+    std::vector<uint8_t> packedIds(static_cast<size_t>(numNodes) * PaperIdDictionary::kPackedLength, 0);
+    std::vector<const std::string*> paperIds(numNodes, nullptr);
+
+    for (const DotNode& node : nodes) {
+        columns.year[node.id] = node.year;
+        columns.citationCount[node.id] = node.citationCount;
+        columns.pageRank[node.id] = node.pageRank;
+        metadata.set(node.id, node.title, node.url, node.abstract);
+        paperIds[node.id] = &node.paperId;
+    }
+
+    // Ids that cannot be packed, and undefined vertices, are kept as (possibly empty) strings
+    std::vector<std::pair<uint32_t, std::string>> otherIds;
+    for (uint32_t v = 0; v < numNodes; ++v) {
+        uint8_t* key = packedIds.data() + static_cast<size_t>(v) * PaperIdDictionary::kPackedLength;
+        if (!paperIds[v]) {
+            otherIds.emplace_back(v, "");
+        } else if (!PaperIdDictionary::pack(*paperIds[v], key)) {
+            otherIds.emplace_back(v, *paperIds[v]);
+        }
+    }
+
+    CsrGraph out = buildCsr(numNodes, edges);
+    CsrGraph in = transposeCsr(out.view());
+
+    GraphSnapshotWriter writer(numNodes, out.numEdges());
+    writer.add(SectionKind::OutOffsets, out.offsets);
+    writer.add(SectionKind::OutTargets, out.neighbors);
+    writer.add(SectionKind::InOffsets, in.offsets);
+    writer.add(SectionKind::InSources, in.neighbors);
+    writer.add(SectionKind::Year, columns.year);
+    writer.add(SectionKind::CitationCount, columns.citationCount);
+    writer.add(SectionKind::PageRank, columns.pageRank);
+    addPaperIdSections(writer, numNodes, packedIds.data(), otherIds);
+    addPaperTextSections(writer, metadata);
+    if (indexes.reachability) addReachabilitySections(writer, out.view());
+    if (indexes.landmarks) {
+        // Files from before pageRank was written have it at 1.0 everywhere, which picks nothing
+        bool ranked = std::any_of(columns.pageRank.begin(), columns.pageRank.end(),
+                                  [&](double rank) { return rank != columns.pageRank.front(); });
+        addLandmarkSections(writer, out.view(), in.view(), columns.pageRank, kDefaultLandmarks,
+                            ranked ? LandmarkSelection::PageRank : LandmarkSelection::Degree);
+    }
+    if (indexes.rankedAdjacency) {
+        addRankedAdjacencySections(writer, out.view(), in.view(), columns.year, columns.citationCount, columns.pageRank);
+    } else if (indexes.rankedOut == ChildRanking::PageRank) {
+        writer.addOwned(SectionKind::OutByPageRank, rankNeighbors(out.view(), columns.pageRank));
+    } else if (indexes.rankedOut == ChildRanking::CitationCount) {
+        writer.addOwned(SectionKind::OutByCitationCount, rankNeighbors(out.view(), columns.citationCount));
+    } else if (indexes.rankedOut == ChildRanking::Year) {
+        writer.addOwned(SectionKind::OutByYear, rankNeighbors(out.view(), columns.year));
+    }
+    return GraphSnapshot::fromImage(writer.writeImage());
+}
+
+// Opens a binary snapshot by memory-mapping it, or loads a DOT file with the requested indexes.
+inline GraphSnapshot openGraph(const std::string& filename, const DotGraphIndexes& indexes = DotGraphIndexes()) {
+    if (GraphSnapshot::isSnapshotFile(filename)) return GraphSnapshot::open(filename);
+    return loadDotGraph(filename, indexes);
+}
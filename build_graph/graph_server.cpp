@@ -0,0 +1,717 @@
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bfs_tree.h"
+#include "dot_graph_loader.h"
+#include "multi_source_bfs.h"
+#include "parallel.h"
+#include "result_cache.h"
+#include "shortest_paths.h"
+#include "tree_store.h"
+
+// Long-running query server: maps the graph snapshot once and answers queries over a Unix
+// domain socket, instead of the API starting find_path or graph_bfs (and loading the graph)
+// for every request. A fixed pool of worker threads serves the connections, each worker with
+// its own search state; every query has a deadline. PATH, TREE and CHILDREN answers are kept
+// in an LRU cache (--cache-mb) tagged with the snapshotId, and the server switches to a rebuilt
+// or re-ranked snapshot file on its own (they are replaced by rename, never patched in place),
+// which clears the cache. TREE requests for
+// papers in the tree store (precompute_trees, --tree-store) are read from it without a traversal.
+// REACH expands many roots in one multi-source BFS.
+//
+// Protocol: one request per line, words separated by spaces, options as key=value.
+//   PING
+//   STATS
+//   INFO <paper>
+//   CHILDREN <paper> [num=N] [by=citationCount|pageRank|random|none] [seed=N]
+//   PATH <start> <end> [depth=15] [undirected=1] [max_paths=N] [k=N] [disjoint=1] [max_overlap=F] [year_slack=N]
+//   TREE <root> <depth> [fan_out=K] [by=pageRank|citationCount|year|random|none] [seed=N]
+//   BOUNDS <start> <end> [undirected=1]
+//   REACH <paper>[:<depth>] ... [depth=2]
+// Every request also takes timeout=MS (default --timeout-ms). The answer is "OK <n>" and n
+// lines, or a single "ERR <message>" line. Papers are Semantic Scholar ids or vertex ids.
+//   INFO, CHILDREN  vertex, paper id, year, citation count, PageRank, url, title (tab separated)
+//   PATH            one path per line, vertex ids from the older paper, as find_path prints them
+//   TREE            vertex, parent, level per line in BFS order, the tree graph_bfs draws; fan_out keeps
+//                   the best K references of each paper (a sample of K with by=random)
+//   BOUNDS          lower and upper hop bounds (upper -1 when unknown), as find_path --bounds
+//   REACH           per paper, in request order: vertex and the number of papers on each level of
+//                   its TREE (the root, its references, theirs, ...); depth -1 means no limit
+
+const size_t kMaxRequestLength = 4096;
+const int kIdleSeconds = 60;  // a connection with no request for this long is closed
+const int kReloadCheckSeconds = 2;  // how often the snapshot file is checked for a rebuild
+const size_t kMaxReachRoots = 256;
+
+struct QueryTimeout {};
+
+struct ServerStats {
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> timeouts{0};
+    std::atomic<uint64_t> reloads{0};
+    std::atomic<uint64_t> storedTrees{0};  // TREE answers read from the tree store
+};
+
+struct Request {
+    std::string command;
+    std::vector<std::string> args;
+    std::map<std::string, std::string> options;
+    std::chrono::steady_clock::time_point deadline;
+
+    std::string option(const std::string& key, const std::string& fallback) const {
+        auto it = options.find(key);
+        return it == options.end() ? fallback : it->second;
+    }
+    long long number(const std::string& key, long long fallback) const {
+        auto it = options.find(key);
+        return it == options.end() ? fallback : std::stoll(it->second);
+    }
+    bool flag(const std::string& key) const { return option(key, "0") != "0"; }
+};
+
+// Search state of one worker thread, built again when the server switches snapshots
+struct QueryWorker {
+    explicit QueryWorker(const GraphSnapshot& graph)
+        : reachability(graph.reachability()), finder(graph.out(), graph.in()), yen(graph.out(), graph.in()), bfs(graph.out()),
+          rng(std::random_device()()) {
+        finder.setYears(graph.years());
+        finder.setReachability(reachability);
+        finder.setLandmarks(graph.landmarks());
+        yen.setYears(graph.years());
+        yen.setReachability(reachability);
+        yen.setLandmarks(graph.landmarks());
+    }
+
+    ReachabilityIndex reachability;  // keeps its visited stamps between PATH queries
+    ShortestPathFinder finder;
+    KShortestPaths yen;
+    BfsTreeBuilder bfs;
+    std::unique_ptr<MultiSourceBfs<1>> reach;  // on the first REACH
+    std::mt19937_64 rng;
+};
+
+// Tabs and newlines would break the line format
+std::string oneLine(std::string_view text) {
+    std::string line(text);
+    std::replace_if(line.begin(), line.end(), [](char c) { return c == '\t' || c == '\n' || c == '\r'; }, ' ');
+    return line;
+}
+
+std::string paperLine(const GraphSnapshot& graph, uint32_t v) {
+    std::ostringstream line;
+    line << v << "\t" << graph.paperId(v) << "\t" << graph.year(v) << "\t" << graph.citationCount(v) << "\t"
+         << graph.pageRank(v) << "\t" << oneLine(graph.url(v)) << "\t" << oneLine(graph.title(v));
+    return line.str();
+}
+
+uint32_t requirePaper(const GraphSnapshot& graph, const std::string& id) {
+    uint32_t v = resolvePaper(graph, id);
+    if (v == GraphSnapshot::kNotFound) throw std::runtime_error("paper not found: " + id);
+    return v;
+}
+
+Request parseRequest(const std::string& line, int defaultTimeoutMs) {
+    Request request;
+    std::istringstream words(line);
+    words >> request.command;
+    std::transform(request.command.begin(), request.command.end(), request.command.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    for (std::string word; words >> word;) {
+        size_t eq = word.find('=');
+        if (eq == std::string::npos) {
+            request.args.push_back(word);
+        } else {
+            request.options[word.substr(0, eq)] = word.substr(eq + 1);
+        }
+    }
+    long long timeoutMs = request.number("timeout", defaultTimeoutMs);
+    request.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(1LL, timeoutMs));
+    return request;
+}
+
+// Canonical key of a cacheable request: the command, its papers as vertex ids in the order the
+// answer uses them and every option but timeout. Empty when the answer must not be reused.
+std::string cacheKey(const GraphSnapshot& graph, const Request& request) {
+    // A random selection is only repeatable with a seed
+    bool seeded = request.option("by", "none") != "random" || request.options.count("seed");
+    bool cacheable = request.command == "PATH" || ((request.command == "TREE" || request.command == "CHILDREN") && seeded);
+    size_t papers = request.command == "PATH" ? 2 : 1;
+    if (!cacheable || request.args.size() < papers) return "";
+    std::vector<std::string> args = request.args;
+    for (size_t i = 0; i < papers; ++i) {
+        uint32_t v = resolvePaper(graph, args[i]);
+        if (v == GraphSnapshot::kNotFound) return "";
+        args[i] = std::to_string(v);
+    }
+    if (request.command == "PATH" && graph.year(std::stoul(args[0])) > graph.year(std::stoul(args[1]))) std::swap(args[0], args[1]);
+    std::string key = request.command;
+    for (const std::string& arg : args) key += " " + arg;
+    for (const auto& option : request.options) {
+        if (option.first != "timeout") key += " " + option.first + "=" + option.second;
+    }
+    return key;
+}
+
+void expectArgs(const Request& request, size_t count, const char* usage) {
+    if (request.args.size() != count) throw std::runtime_error(std::string("usage: ") + usage);
+}
+
+std::vector<std::string> answerPath(const GraphSnapshot& graph, const Request& request, QueryWorker& worker) {
+    expectArgs(request, 2,
+               "PATH <start> <end> [depth=15] [undirected=1] [max_paths=N] [k=N] [disjoint=1] [max_overlap=F] [year_slack=N]");
+    uint32_t start = requirePaper(graph, request.args[0]);
+    uint32_t end = requirePaper(graph, request.args[1]);
+    // Paths start from the older paper, as in find_path
+    if (graph.year(start) > graph.year(end)) std::swap(start, end);
+
+    ShortestPathOptions options;
+    options.direction = request.flag("undirected") ? PathDirection::Undirected : PathDirection::Directed;
+    options.maxDepth = static_cast<int>(request.number("depth", options.maxDepth));
+    options.maxPaths = static_cast<size_t>(std::max(1LL, request.number("max_paths", static_cast<long long>(options.maxPaths))));
+    options.deadline = request.deadline;
+    long long yearSlack = request.number("year_slack", -1);
+    if (yearSlack >= 0) {
+        std::pair<int, int> window = yearWindow(graph.year(start), graph.year(end), static_cast<int>(yearSlack));
+        options.minYear = window.first;
+        options.maxYear = window.second;
+    }
+
+    std::vector<std::vector<uint32_t>> paths;
+    if (options.direction == PathDirection::Directed && worker.reachability.exact() && !worker.reachability.reachable(start, end)) {
+        return {};
+    }
+    if (request.options.count("k") || request.flag("disjoint") || request.options.count("max_overlap")) {
+        KShortestPathOptions kOptions;
+        kOptions.direction = options.direction;
+        kOptions.maxDepth = options.maxDepth;
+        kOptions.k = static_cast<size_t>(std::min(100LL, std::max(1LL, request.number("k", static_cast<long long>(kOptions.k)))));
+        kOptions.disjoint = request.flag("disjoint");
+        kOptions.maxOverlap = std::stod(request.option("max_overlap", "1"));
+        kOptions.minYear = options.minYear;
+        kOptions.maxYear = options.maxYear;
+        kOptions.deadline = request.deadline;
+        KShortestPathStats stats;
+        paths = worker.yen.find(start, end, kOptions, &stats);
+        if (stats.timedOut) throw QueryTimeout();
+    } else {
+        ShortestPathStats stats;
+        worker.finder.find(start, end, options, paths, &stats);
+        if (stats.timedOut) throw QueryTimeout();
+    }
+
+    std::vector<std::string> lines;
+    for (const std::vector<uint32_t>& path : paths) {
+        std::ostringstream line;
+        for (size_t i = 0; i < path.size(); ++i) line << (i > 0 ? " " : "") << path[i];
+        lines.push_back(line.str());
+    }
+    return lines;
+}
+
+std::vector<std::string> answerChildren(const GraphSnapshot& graph, const Request& request, QueryWorker& worker) {
+    expectArgs(request, 1, "CHILDREN <paper> [num=N] [by=citationCount|pageRank|random|none] [seed=N]");
+    uint32_t paper = requirePaper(graph, request.args[0]);
+    std::string by = request.option("by", "none");
+    ChildRanking ranking;
+    if (!parseChildRanking(by, ranking) || ranking == ChildRanking::Year) throw std::runtime_error("unknown selection: " + by);
+    long long num = request.number("num", 0);
+    size_t limit = num > 0 ? static_cast<size_t>(num) : SIZE_MAX;
+
+    // With the best-first rows in the snapshot the top num citers are a prefix of the row
+    CsrView ranked = graph.rankedIn(ranking);
+    std::vector<uint32_t> children;
+    if (ranked.numNodes == graph.numNodes()) {
+        ArrayView<uint32_t> citers = ranked.neighborsOf(paper);
+        children.assign(citers.begin(), citers.begin() + std::min(limit, citers.size()));
+    } else {
+        ArrayView<uint32_t> citers = graph.inEdges(paper);
+        children.assign(citers.begin(), citers.end());
+        if (ranking == ChildRanking::CitationCount) {
+            std::stable_sort(children.begin(), children.end(),
+                             [&](uint32_t a, uint32_t b) { return graph.citationCount(a) > graph.citationCount(b); });
+        } else if (ranking == ChildRanking::PageRank) {
+            std::stable_sort(children.begin(), children.end(),
+                             [&](uint32_t a, uint32_t b) { return graph.pageRank(a) > graph.pageRank(b); });
+        } else if (ranking == ChildRanking::Random) {
+            std::mt19937_64 rng(request.options.count("seed") ? static_cast<uint64_t>(request.number("seed", 0)) : worker.rng());
+            std::shuffle(children.begin(), children.end(), rng);
+        }
+        if (limit < children.size()) children.resize(limit);
+    }
+
+    std::vector<std::string> lines;
+    for (uint32_t child : children) lines.push_back(paperLine(graph, child));
+    return lines;
+}
+
+std::vector<std::string> answerTree(const GraphSnapshot& graph, const TreeStore& trees, const Request& request, QueryWorker& worker,
+                                    ServerStats& stats) {
+    expectArgs(request, 2, "TREE <root> <depth> [fan_out=K] [by=pageRank|citationCount|year|random|none] [seed=N]");
+    uint32_t root = requirePaper(graph, request.args[0]);
+    TreeFanOut fanOut;
+    fanOut.limit = static_cast<uint32_t>(std::max(0LL, request.number("fan_out", 0)));
+    std::string by = request.option("by", "none");
+    if (!parseChildRanking(by, fanOut.ranking)) throw std::runtime_error("unknown selection: " + by);
+    fanOut.seed = request.options.count("seed") ? static_cast<uint64_t>(request.number("seed", 0)) : worker.rng();
+    CsrView ranked = graph.rankedOut(fanOut.ranking == ChildRanking::Random ? ChildRanking::None : fanOut.ranking);
+    if (ranked.numNodes != graph.numNodes()) throw std::runtime_error("no " + by + " order in the snapshot");
+    int depth = std::stoi(request.args[1]);
+    BfsTree tree;
+    if (trees.covers(graph, root, depth, fanOut)) {
+        tree = trees.tree(root, depth);
+        ++stats.storedTrees;
+    } else {
+        tree = worker.bfs.build(root, depth, ranked, fanOut, request.deadline);
+    }
+    if (tree.timedOut) throw QueryTimeout();
+    std::vector<std::string> lines;
+    lines.reserve(tree.vertices.size());
+    for (size_t i = 0; i < tree.vertices.size(); ++i) {
+        lines.push_back(std::to_string(tree.vertices[i]) + " " + std::to_string(tree.parents[i]) + " " +
+                        std::to_string(tree.levels[i]));
+    }
+    return lines;
+}
+
+std::vector<std::string> answerBounds(const GraphSnapshot& graph, const Request& request) {
+    expectArgs(request, 2, "BOUNDS <start> <end> [undirected=1]");
+    uint32_t start = requirePaper(graph, request.args[0]);
+    uint32_t end = requirePaper(graph, request.args[1]);
+    if (graph.year(start) > graph.year(end)) std::swap(start, end);
+    LandmarkOracle landmarks = graph.landmarks();
+    if (landmarks.empty()) throw std::runtime_error("no landmark distances in the snapshot");
+    DistanceBounds bounds = landmarks.bounds(start, end, request.flag("undirected"));
+    if (bounds.lower == DistanceBounds::kNoPath) return {};
+    long long upper = bounds.upper == DistanceBounds::kNoPath ? -1 : static_cast<long long>(bounds.upper);
+    return {std::to_string(bounds.lower) + " " + std::to_string(upper)};
+}
+
+std::vector<std::string> answerReach(const GraphSnapshot& graph, const Request& request, QueryWorker& worker) {
+    if (request.args.empty() || request.args.size() > kMaxReachRoots) {
+        throw std::runtime_error("usage: REACH <paper>[:<depth>] ... [depth=2], at most " + std::to_string(kMaxReachRoots) + " papers");
+    }
+    int defaultDepth = static_cast<int>(request.number("depth", 2));
+    std::vector<uint32_t> roots;
+    std::vector<int> depths;
+    for (const std::string& arg : request.args) {
+        size_t colon = arg.rfind(':');
+        roots.push_back(requirePaper(graph, arg.substr(0, colon)));
+        depths.push_back(colon == std::string::npos ? defaultDepth : std::stoi(arg.substr(colon + 1)));
+    }
+    if (!worker.reach) worker.reach.reset(new MultiSourceBfs<1>(graph.out()));
+    std::vector<std::vector<uint32_t>> sizes = worker.reach->levelSizes(roots, depths, request.deadline);
+    if (sizes.empty()) throw QueryTimeout();
+    std::vector<std::string> lines;
+    for (size_t i = 0; i < roots.size(); ++i) {
+        std::string line = std::to_string(roots[i]);
+        for (uint32_t size : sizes[i]) line += " " + std::to_string(size);
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// A client connection, the part of a request line read so far and the part of an answer the
+// client has not taken yet. inWorker and closed are guarded by the server mutex; the rest belongs
+// to the worker while inWorker is set and to the main thread otherwise.
+struct Connection {
+    Connection(int fd, std::chrono::steady_clock::time_point lastActive) : fd(fd), lastActive(lastActive) {}
+
+    int fd;
+    std::string buffer;
+    std::chrono::steady_clock::time_point lastActive;
+    std::string output;
+    size_t outputSent = 0;
+    bool inWorker = false;
+    bool closed = false;
+};
+
+// The main thread polls the listening socket and the idle connections; a connection with data
+// goes to a worker, which answers every complete request in it and hands it back. Sockets are
+// non-blocking: an answer the client does not read right away stays with its connection, whose
+// further requests wait, and the main thread sends the rest as the socket takes it. So a few
+// workers serve any number of connections, and a slow query or a client that stops reading only
+// holds up that client.
+class GraphServer {
+public:
+    GraphServer(const std::string& filename, std::shared_ptr<const GraphSnapshot> graph, const std::string& treeStoreFilename,
+                unsigned numThreads, int timeoutMs, size_t cacheBytes)
+        : filename_(filename), treeStoreFilename_(treeStoreFilename), graph_(std::move(graph)),
+          trees_(std::make_shared<const TreeStore>()), numThreads_(numThreads), timeoutMs_(timeoutMs), cache_(cacheBytes) {
+        if (pipe(wake_) != 0) throw std::runtime_error("Cannot create pipe");
+        reloadTreeStoreIfChanged();
+    }
+
+    ~GraphServer() {
+        close(wake_[0]);
+        close(wake_[1]);
+    }
+
+    // Full response text for one request line
+    std::string handle(const std::string& line, const GraphSnapshot& graph, const TreeStore& trees, QueryWorker& worker) {
+        ++stats_.requests;
+        std::vector<std::string> lines;
+        std::string key;
+        try {
+            Request request = parseRequest(line, timeoutMs_);
+            if (cache_.enabled()) key = cacheKey(graph, request);
+            if (!key.empty()) {
+                if (ResultCache::Value cached = cache_.find(key, graph.snapshotId())) return *cached;
+            }
+            if (request.command == "PING") {
+            } else if (request.command == "STATS") {
+                ResultCacheStats cache = cache_.stats();
+                std::ostringstream text;
+                text << "nodes=" << graph.numNodes() << " edges=" << graph.numEdges() << " snapshot=" << graph.snapshotId()
+                     << " threads=" << numThreads_ << " requests=" << stats_.requests << " errors=" << stats_.errors
+                     << " timeouts=" << stats_.timeouts << " reloads=" << stats_.reloads << " stored_trees=" << trees.numTrees()
+                     << " stored_tree_answers=" << stats_.storedTrees << " cache_entries=" << cache.entries
+                     << " cache_bytes=" << cache.bytes << " cache_hits=" << cache.hits << " cache_misses=" << cache.misses
+                     << " cache_evictions=" << cache.evictions << " cache_invalidations=" << cache.invalidations;
+                lines.push_back(text.str());
+            } else if (request.command == "INFO") {
+                expectArgs(request, 1, "INFO <paper>");
+                lines.push_back(paperLine(graph, requirePaper(graph, request.args[0])));
+            } else if (request.command == "CHILDREN") {
+                lines = answerChildren(graph, request, worker);
+            } else if (request.command == "PATH") {
+                lines = answerPath(graph, request, worker);
+            } else if (request.command == "TREE") {
+                lines = answerTree(graph, trees, request, worker, stats_);
+            } else if (request.command == "BOUNDS") {
+                lines = answerBounds(graph, request);
+            } else if (request.command == "REACH") {
+                lines = answerReach(graph, request, worker);
+            } else {
+                throw std::runtime_error("unknown command: " + request.command);
+            }
+        } catch (const QueryTimeout&) {
+            ++stats_.timeouts;
+            return "ERR timeout\n";
+        } catch (const std::runtime_error& e) {
+            ++stats_.errors;
+            return "ERR " + oneLine(e.what()) + "\n";
+        } catch (const std::exception&) {
+            // std::stoi and friends on a malformed number
+            ++stats_.errors;
+            return "ERR bad request\n";
+        }
+        std::string response = "OK " + std::to_string(lines.size()) + "\n";
+        for (const std::string& l : lines) response += l + "\n";
+        if (!key.empty()) cache_.insert(key, graph.snapshotId(), std::make_shared<const std::string>(response));
+        return response;
+    }
+
+    // Accepts and dispatches on the calling thread until stopRequested becomes true
+    void run(int listener, const std::atomic<bool>& stopRequested) {
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < numThreads_; ++t) workers.emplace_back([this]() { runWorker(); });
+
+        std::vector<std::unique_ptr<Connection>> connections;
+        std::vector<pollfd> polled;
+        std::vector<Connection*> polledConnections;
+        auto lastReloadCheck = std::chrono::steady_clock::now();
+        while (!stopRequested) {
+            polled.assign({pollfd{listener, POLLIN, 0}, pollfd{wake_[0], POLLIN, 0}});
+            polledConnections.assign(2, nullptr);
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastReloadCheck > std::chrono::seconds(kReloadCheckSeconds)) {
+                reloadIfChanged();
+                reloadTreeStoreIfChanged();
+                lastReloadCheck = now;
+            }
+            {
+                // Closed and idle connections are dropped; the rest are polled unless a worker has them
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (size_t i = 0; i < connections.size();) {
+                    Connection* connection = connections[i].get();
+                    if (connection->inWorker) {
+                        ++i;
+                    } else if (connection->closed || now - connection->lastActive > std::chrono::seconds(kIdleSeconds)) {
+                        close(connection->fd);
+                        connections[i] = std::move(connections.back());
+                        connections.pop_back();
+                    } else {
+                        short events = connection->output.empty() ? POLLIN : POLLOUT;
+                        polled.push_back(pollfd{connection->fd, events, 0});
+                        polledConnections.push_back(connection);
+                        ++i;
+                    }
+                }
+            }
+            if (poll(polled.data(), polled.size(), 200) <= 0) continue;
+
+            if (polled[1].revents & POLLIN) {
+                char drain[64];
+                if (read(wake_[0], drain, sizeof(drain)) < 0) continue;
+            }
+            if (polled[0].revents & POLLIN) {
+                int client = accept(listener, nullptr, nullptr);
+                if (client >= 0 && fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK) == 0) {
+                    connections.emplace_back(new Connection(client, now));
+                } else if (client >= 0) {
+                    close(client);
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 2; i < polled.size(); ++i) {
+                if (polled[i].revents == 0) continue;
+                Connection* connection = polledConnections[i];
+                // The rest of an answer goes out here; the next request needs a worker again
+                if (!connection->output.empty()) {
+                    size_t pending = connection->output.size() - connection->outputSent;
+                    if (!flush(*connection)) {
+                        connection->closed = true;
+                        continue;
+                    }
+                    if (connection->output.size() - connection->outputSent < pending) connection->lastActive = now;
+                    if (!connection->output.empty() || connection->buffer.find('\n') == std::string::npos) continue;
+                }
+                connection->inWorker = true;
+                readable_.push_back(connection);
+                ready_.notify_one();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            ready_.notify_all();
+        }
+        for (std::thread& worker : workers) worker.join();
+        for (auto& connection : connections) close(connection->fd);
+    }
+
+private:
+    // Switches to the snapshot file's current contents when main or pagerank has replaced it. Workers
+    // finish their connection on the graph they started with; the old mapping goes with the last of them.
+    void reloadIfChanged() {
+        uint64_t id = GraphSnapshot::fileSnapshotId(filename_);
+        if (id == 0 || id == graph_->snapshotId() || id == failedReload_) return;
+        std::shared_ptr<const GraphSnapshot> graph;
+        try {
+            graph = std::make_shared<const GraphSnapshot>(GraphSnapshot::open(filename_));
+        } catch (const std::exception& e) {
+            std::cerr << "Cannot reload " << filename_ << ": " << e.what() << std::endl;
+            failedReload_ = id;
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            graph_ = graph;
+        }
+        cache_.clear();
+        ++stats_.reloads;
+        std::cerr << "Reloaded " << filename_ << " (" << graph->numNodes() << " nodes, " << graph->numEdges() << " edges)"
+                  << std::endl;
+    }
+
+    // Maps the tree store again when precompute_trees has rewritten it. A store built from
+    // another snapshot is kept but not used (TreeStore::covers checks the snapshotId).
+    void reloadTreeStoreIfChanged() {
+        if (treeStoreFilename_.empty()) return;
+        uint64_t id = TreeStore::fileStoreId(treeStoreFilename_);
+        if (id == 0 || id == trees_->storeId() || id == failedTreeStore_) return;
+        std::shared_ptr<const TreeStore> trees;
+        try {
+            trees = std::make_shared<const TreeStore>(TreeStore::open(treeStoreFilename_));
+        } catch (const std::exception& e) {
+            std::cerr << "Cannot load " << treeStoreFilename_ << ": " << e.what() << std::endl;
+            failedTreeStore_ = id;
+            return;
+        }
+        std::shared_ptr<const GraphSnapshot> graph;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            trees_ = trees;
+            graph = graph_;
+        }
+        std::cerr << "Loaded " << trees->numTrees() << " trees of depth " << trees->depth() << " from " << treeStoreFilename_
+                  << (trees->snapshotId() == graph->snapshotId() ? "" : " (built from another snapshot, not used)") << std::endl;
+    }
+
+    void runWorker() {
+        std::shared_ptr<const GraphSnapshot> graph;
+        std::shared_ptr<const TreeStore> trees;
+        std::unique_ptr<QueryWorker> worker;
+        while (true) {
+            Connection* connection;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [&] { return stopping_ || !readable_.empty(); });
+                if (stopping_) return;
+                connection = readable_.front();
+                readable_.pop_front();
+                if (graph != graph_) {
+                    graph = graph_;
+                    worker.reset();
+                }
+                trees = trees_;
+            }
+            if (!worker) worker.reset(new QueryWorker(*graph));
+            bool open = serve(*connection, *graph, *trees, *worker);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                connection->closed = !open;
+                connection->inWorker = false;
+                connection->lastActive = std::chrono::steady_clock::now();
+            }
+            char wake = 0;
+            if (write(wake_[1], &wake, 1) < 0) {
+                // The poll timeout picks the connection up anyway
+            }
+        }
+    }
+
+    // Reads what the client sent and answers the complete requests, up to the first answer the
+    // socket does not take in full; false once the connection is closed
+    bool serve(Connection& connection, const GraphSnapshot& graph, const TreeStore& trees, QueryWorker& worker) {
+        char chunk[4096];
+        ssize_t received = recv(connection.fd, chunk, sizeof(chunk), 0);
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) return false;
+        if (received > 0) connection.buffer.append(chunk, static_cast<size_t>(received));
+        for (size_t newline; connection.output.empty() && (newline = connection.buffer.find('\n')) != std::string::npos;) {
+            std::string line = connection.buffer.substr(0, newline);
+            connection.buffer.erase(0, newline + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            connection.output = handle(line, graph, trees, worker);
+            if (!flush(connection)) return false;
+        }
+        if (connection.buffer.size() > kMaxRequestLength && connection.buffer.find('\n') == std::string::npos) {
+            connection.output += "ERR request too long\n";
+            flush(connection);
+            return false;
+        }
+        return true;
+    }
+
+    // Sends as much of the pending answer as the socket takes without blocking; false once the
+    // client is gone
+    static bool flush(Connection& connection) {
+        while (connection.outputSent < connection.output.size()) {
+            ssize_t n = send(connection.fd, connection.output.data() + connection.outputSent,
+                             connection.output.size() - connection.outputSent, MSG_NOSIGNAL);
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+            if (n <= 0) return false;
+            connection.outputSent += static_cast<size_t>(n);
+        }
+        connection.output.clear();
+        connection.outputSent = 0;
+        return true;
+    }
+
+    std::string filename_;
+    std::string treeStoreFilename_;
+    std::shared_ptr<const GraphSnapshot> graph_;  // guarded by mutex_; replaced by reloadIfChanged
+    std::shared_ptr<const TreeStore> trees_;      // guarded by mutex_; empty without a store
+    uint64_t failedReload_ = 0;
+    uint64_t failedTreeStore_ = 0;
+    unsigned numThreads_;
+    int timeoutMs_;
+    ServerStats stats_;
+    ResultCache cache_;
+    int wake_[2];
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<Connection*> readable_;  // waiting for a worker
+    bool stopping_ = false;
+};
+
+std::atomic<bool> stopRequested(false);
+
+void requestStop(int) { stopRequested = true; }
+
+int main(int argc, char* argv[]) {
+    // g++ -std=c++17 -O2 -pthread -o graph_server graph_server.cpp
+    std::string graph_filename = "data/citation_network.snapshot";
+    std::string socket_path = "data/graph_server.sock";
+    unsigned threads = defaultThreadCount();
+    int timeoutMs = 2000;
+    size_t cacheMb = 64;
+    std::string tree_store = "data/bfs_trees.store";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--socket=", 0) == 0) {
+            socket_path = arg.substr(9);
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            threads = static_cast<unsigned>(std::max(1, std::stoi(arg.substr(10))));
+        } else if (arg.rfind("--timeout-ms=", 0) == 0) {
+            timeoutMs = std::max(1, std::stoi(arg.substr(13)));
+        } else if (arg.rfind("--cache-mb=", 0) == 0) {
+            cacheMb = std::stoul(arg.substr(11));
+        } else if (arg.rfind("--tree-store=", 0) == 0) {
+            tree_store = arg.substr(13);
+        } else if (arg.rfind("--", 0) != 0) {
+            graph_filename = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [dot or snapshot file name] [--socket=path] [--threads=N] [--timeout-ms=N]"
+                      << " [--cache-mb=N] [--tree-store=data/bfs_trees.store]"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    std::shared_ptr<const GraphSnapshot> graph;
+    try {
+        // A DOT file is loaded once for the whole run, so with every index the snapshot would have
+        DotGraphIndexes indexes;
+        indexes.reachability = true;
+        indexes.landmarks = true;
+        indexes.rankedAdjacency = true;
+        graph = std::make_shared<const GraphSnapshot>(openGraph(graph_filename, indexes));
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading graph: " << e.what() << std::endl;
+        return 1;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << socket_path << std::endl;
+        return 1;
+    }
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path.c_str());
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 128) != 0) {
+        std::cerr << "Cannot listen on " << socket_path << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+
+    std::cerr << "Serving " << graph_filename << " (" << graph->numNodes() << " nodes, " << graph->numEdges() << " edges) on "
+              << socket_path << " with " << threads << " threads, " << timeoutMs << " ms timeout, " << cacheMb << " MB cache"
+              << std::endl;
+    GraphServer server(graph_filename, graph, tree_store, threads, timeoutMs, cacheMb << 20);
+    server.run(listener, stopRequested);
+    close(listener);
+    unlink(socket_path.c_str());
+    std::cerr << "Stopped" << std::endl;
+    return 0;
+}
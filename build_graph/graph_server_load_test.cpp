@@ -0,0 +1,237 @@
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Load test for graph_server: N clients, each on its own connection, send a random mix of
+// queries between random papers and time every answer. Prints p50 / p99 / max latency per
+// query type and the overall throughput. --hot=N draws the papers from a fixed set of N, the
+// way the same popular papers come back again and again, to exercise the server's cache.
+
+struct QueryType {
+    std::string name;
+    int weight;
+};
+
+struct Sample {
+    size_t type;
+    double ms;
+    bool ok;
+    bool timedOut;
+};
+
+class ServerConnection {
+public:
+    explicit ServerConnection(const std::string& path) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd_ < 0 || connect(fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            if (fd_ >= 0) close(fd_);
+            throw std::runtime_error("Cannot connect to " + path + ": " + std::strerror(errno));
+        }
+    }
+    ~ServerConnection() { close(fd_); }
+    ServerConnection(const ServerConnection&) = delete;
+    ServerConnection& operator=(const ServerConnection&) = delete;
+
+    // Sends one request; returns the status line and fills lines with the answer
+    std::string query(const std::string& request, std::vector<std::string>& lines) {
+        std::string data = request + "\n";
+        for (size_t sent = 0; sent < data.size();) {
+            ssize_t n = send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) throw std::runtime_error("Connection lost");
+            sent += static_cast<size_t>(n);
+        }
+        lines.clear();
+        std::string status = readLine();
+        if (status.rfind("OK ", 0) == 0) {
+            size_t count = std::stoul(status.substr(3));
+            for (size_t i = 0; i < count; ++i) lines.push_back(readLine());
+        }
+        return status;
+    }
+
+private:
+    std::string readLine() {
+        while (true) {
+            size_t newline = buffer_.find('\n', scanned_);
+            if (newline != std::string::npos) {
+                std::string line = buffer_.substr(0, newline);
+                buffer_.erase(0, newline + 1);
+                scanned_ = 0;
+                return line;
+            }
+            scanned_ = buffer_.size();
+            char chunk[65536];
+            ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+            if (n <= 0) throw std::runtime_error("Connection lost");
+            buffer_.append(chunk, static_cast<size_t>(n));
+        }
+    }
+
+    int fd_ = -1;
+    std::string buffer_;
+    size_t scanned_ = 0;
+};
+
+double percentile(std::vector<double>& values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+int main(int argc, char* argv[]) {
+    // g++ -std=c++17 -O2 -pthread -o graph_server_load_test graph_server_load_test.cpp
+    std::string socket_path = "data/graph_server.sock";
+    unsigned clients = 8;
+    size_t requests = 500;
+    int treeDepth = 2;
+    uint32_t hotPapers = 0;
+    std::vector<QueryType> types = {{"path", 4}, {"tree", 2}, {"children", 2}, {"info", 2}};
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--socket=", 0) == 0) {
+            socket_path = arg.substr(9);
+        } else if (arg.rfind("--clients=", 0) == 0) {
+            clients = static_cast<unsigned>(std::max(1, std::stoi(arg.substr(10))));
+        } else if (arg.rfind("--requests=", 0) == 0) {
+            requests = std::stoul(arg.substr(11));
+        } else if (arg.rfind("--tree-depth=", 0) == 0) {
+            treeDepth = std::stoi(arg.substr(13));
+        } else if (arg.rfind("--hot=", 0) == 0) {
+            hotPapers = static_cast<uint32_t>(std::stoul(arg.substr(6)));
+        } else if (arg.rfind("--mix=", 0) == 0) {
+            // e.g. --mix=path:4,tree:1
+            types.clear();
+            std::istringstream mix(arg.substr(6));
+            for (std::string entry; std::getline(mix, entry, ',');) {
+                size_t colon = entry.find(':');
+                types.push_back({entry.substr(0, colon), colon == std::string::npos ? 1 : std::stoi(entry.substr(colon + 1))});
+            }
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--socket=path] [--clients=N] [--requests=N per client]"
+                      << " [--mix=path:4,tree:2,children:2,info:2,bounds:1] [--tree-depth=N]"
+                      << " [--hot=N papers]" << std::endl;
+            return 1;
+        }
+    }
+
+    uint32_t numNodes = 0;
+    try {
+        ServerConnection connection(socket_path);
+        std::vector<std::string> lines;
+        connection.query("STATS", lines);
+        if (lines.empty() || lines[0].rfind("nodes=", 0) != 0) throw std::runtime_error("Unexpected STATS answer");
+        numNodes = static_cast<uint32_t>(std::stoul(lines[0].substr(6)));
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (numNodes == 0) {
+        std::cerr << "Empty graph" << std::endl;
+        return 1;
+    }
+    int totalWeight = 0;
+    for (const QueryType& type : types) totalWeight += std::max(0, type.weight);
+    if (totalWeight == 0) {
+        std::cerr << "Empty query mix" << std::endl;
+        return 1;
+    }
+
+    std::vector<uint32_t> hot;
+    std::mt19937_64 hotRng(7);
+    for (uint32_t i = 0; i < hotPapers; ++i) hot.push_back(static_cast<uint32_t>(hotRng() % numNodes));
+    auto pickPaper = [&](std::mt19937_64& rng) {
+        return hot.empty() ? static_cast<uint32_t>(rng() % numNodes) : hot[rng() % hot.size()];
+    };
+
+    std::vector<std::vector<Sample>> samples(clients);
+    std::vector<std::string> failures(clients);
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c]() {
+            try {
+                ServerConnection connection(socket_path);
+                std::mt19937_64 rng(1000 + c);
+                std::vector<std::string> lines;
+                for (size_t r = 0; r < requests; ++r) {
+                    int pick = static_cast<int>(rng() % totalWeight);
+                    size_t type = 0;
+                    while (pick >= types[type].weight) pick -= types[type++].weight;
+                    uint32_t a = pickPaper(rng);
+                    uint32_t b = pickPaper(rng);
+                    std::string request;
+                    const std::string& name = types[type].name;
+                    if (name == "path") request = "PATH " + std::to_string(a) + " " + std::to_string(b);
+                    else if (name == "tree") request = "TREE " + std::to_string(a) + " " + std::to_string(treeDepth);
+                    else if (name == "children") request = "CHILDREN " + std::to_string(a) + " num=20 by=pageRank";
+                    else if (name == "bounds") request = "BOUNDS " + std::to_string(a) + " " + std::to_string(b);
+                    else request = "INFO " + std::to_string(a);
+
+                    auto start = std::chrono::steady_clock::now();
+                    std::string status = connection.query(request, lines);
+                    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    samples[c].push_back(Sample{type, ms, status.rfind("OK ", 0) == 0, status == "ERR timeout"});
+                }
+            } catch (const std::exception& e) {
+                failures[c] = e.what();
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    for (const std::string& failure : failures) {
+        if (!failure.empty()) std::cerr << "Client failed: " << failure << std::endl;
+    }
+    size_t total = 0;
+    std::cout << clients << " clients x " << requests << " requests against " << socket_path << " (" << numNodes
+              << " papers)" << std::endl;
+    std::cout << "  query      count  errors  timeouts    p50 ms    p99 ms    max ms" << std::endl;
+    for (size_t t = 0; t <= types.size(); ++t) {
+        std::vector<double> latencies;
+        size_t errors = 0;
+        size_t timeouts = 0;
+        for (const std::vector<Sample>& client : samples) {
+            for (const Sample& sample : client) {
+                if (t < types.size() && sample.type != t) continue;
+                latencies.push_back(sample.ms);
+                errors += sample.ok ? 0 : 1;
+                timeouts += sample.timedOut ? 1 : 0;
+            }
+        }
+        if (t == types.size()) total = latencies.size();
+        if (latencies.empty()) continue;
+        double maxMs = *std::max_element(latencies.begin(), latencies.end());
+        std::cout << "  " << std::left << std::setw(9) << (t < types.size() ? types[t].name : "all") << std::right
+                  << std::setw(7) << latencies.size() << std::setw(8) << errors << std::setw(10) << timeouts << std::fixed
+                  << std::setprecision(3) << std::setw(10) << percentile(latencies, 0.5) << std::setw(10)
+                  << percentile(latencies, 0.99) << std::setw(10) << maxMs << std::endl;
+    }
+    std::cout << "  " << std::fixed << std::setprecision(0) << total / seconds << " requests/s over " << std::setprecision(2)
+              << seconds << " s" << std::endl;
+    try {
+        ServerConnection connection(socket_path);
+        std::vector<std::string> lines;
+        connection.query("STATS", lines);
+        if (!lines.empty()) std::cout << "  server: " << lines[0] << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+    return 0;
+}
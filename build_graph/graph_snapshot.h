@@ -0,0 +1,549 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "landmarks.h"
+#include "mapped_file.h"
+#include "paper_columns.h"
+#include "paper_id_dictionary.h"
+#include "ranked_adjacency.h"
+#include "reachability.h"
+
+// Binary graph snapshot written by main.cpp and memory-mapped by the query tools.
+//
+// Layout: a fixed SnapshotHeader followed by 64-byte aligned sections. The header's section
+// table says where each section lives; readers look sections up by kind and ignore kinds they
+// do not know, so new optional sections do not need a version bump. kSnapshotVersion changes
+// only when the encoding of an existing section changes.
+
+const char kSnapshotMagic[8] = {'P', 'V', 'G', 'R', 'A', 'P', 'H', '\0'};
+const uint32_t kSnapshotVersion = 1;
+const uint32_t kMaxSnapshotSections = 48;
+const size_t kSnapshotAlignment = 64;
+
+enum class SectionKind : uint32_t {
+    OutOffsets = 1,      // uint64_t[numNodes + 1], CSR of citing -> cited edges
+    OutTargets = 2,      // uint32_t[numEdges]
+    InOffsets = 3,       // uint64_t[numNodes + 1], CSC (cited <- citing)
+    InSources = 4,       // uint32_t[numEdges]
+    Year = 5,            // int32_t[numNodes]
+    CitationCount = 6,   // int32_t[numNodes]
+    PageRank = 7,        // double[numNodes]
+    PaperIdsPacked = 8,  // 20 bytes per vertex, hex paper id packed to binary
+    PaperIdsOther = 9,   // {uint32_t vertex, uint32_t length, char[length]} records for non-hex ids, 4-byte aligned
+    PaperIdIndex = 10,   // uint32_t vertices with packed ids, sorted by packed id
+    TextEntries = 11,    // PaperTextEntry[numNodes]
+    TextArena = 12,      // char[], titles, urls and abstracts
+    OriginalVertex = 13, // uint32_t[numNodes], optional: build-order id of each vertex after --reorder
+    ComponentRank = 14,  // uint32_t[numNodes], optional: SCC in reverse topological order (reachability.h)
+    ComponentDagOffsets = 15, // uint64_t[numComponents + 1], optional: CSR of the condensed citation DAG
+    ComponentDagTargets = 16, // uint32_t[], optional
+    GrailLabels = 17,    // uint32_t[numComponents * traversals * 2], optional: {low, post} per component and traversal
+    Landmarks = 18,      // uint32_t[k], optional: landmark vertices of the distance oracle (landmarks.h)
+    LandmarkDistances = 19, // uint8_t[numNodes * 3 * k], optional: hops from, to and undirected to each landmark
+    OutByPageRank = 20,  // uint32_t[numEdges], optional: OutTargets with every row sorted best first (ranked_adjacency.h)
+    OutByCitationCount = 21, // uint32_t[numEdges], optional
+    OutByYear = 22,      // uint32_t[numEdges], optional: newest first
+    InByPageRank = 23,   // uint32_t[numEdges], optional: InSources with every row sorted best first
+    InByCitationCount = 24, // uint32_t[numEdges], optional
+};
+
+struct SnapshotSection {
+    uint32_t kind;
+    uint32_t elementSize;
+    uint64_t offset;
+    uint64_t bytes;
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sectionCount;
+    uint64_t numNodes;
+    uint64_t numEdges;
+    uint64_t snapshotId; // changes whenever the snapshot is rewritten
+    uint64_t reserved[3];
+    SnapshotSection sections[kMaxSnapshotSections];
+};
+
+const std::string kSemanticScholarUrl = "https://www.semanticscholar.org/paper/";
+
+inline uint64_t newSnapshotId() {
+    std::random_device device;
+    uint64_t id = static_cast<uint64_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    return id ^ (static_cast<uint64_t>(device()) << 32) ^ device();
+}
+
+// Collects sections and writes them out in one pass. Sections added by pointer must stay
+// alive until write; addOwned keeps its own copy.
+class GraphSnapshotWriter {
+public:
+    GraphSnapshotWriter(uint64_t numNodes, uint64_t numEdges) : numNodes_(numNodes), numEdges_(numEdges) {}
+
+    void add(SectionKind kind, const void* data, size_t bytes, uint32_t elementSize) {
+        if (pending_.size() == kMaxSnapshotSections) throw std::runtime_error("Too many snapshot sections");
+        pending_.push_back(Pending{kind, elementSize, static_cast<const char*>(data), bytes});
+    }
+
+    template <typename T>
+    void add(SectionKind kind, const std::vector<T>& values) {
+        add(kind, values.data(), values.size() * sizeof(T), sizeof(T));
+    }
+
+    template <typename T>
+    void addOwned(SectionKind kind, std::vector<T> values) {
+        owned_.emplace_back(reinterpret_cast<const char*>(values.data()),
+                            reinterpret_cast<const char*>(values.data() + values.size()));
+        add(kind, owned_.back().data(), owned_.back().size(), sizeof(T));
+    }
+
+    // Through replaceFile, so readers never map a half-written file.
+    void writeFile(const std::string& filename) const {
+        replaceFile(filename, "snapshot file", [&](auto write) { emit(write); });
+    }
+
+    std::vector<char> writeImage() const {
+        std::vector<char> image;
+        emit([&](const char* data, size_t bytes) { image.insert(image.end(), data, data + bytes); });
+        return image;
+    }
+
+private:
+    struct Pending {
+        SectionKind kind;
+        uint32_t elementSize;
+        const char* data;
+        size_t bytes;
+    };
+
+    template <typename Sink>
+    void emit(Sink sink) const {
+        SnapshotHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+        header.version = kSnapshotVersion;
+        header.sectionCount = static_cast<uint32_t>(pending_.size());
+        header.numNodes = numNodes_;
+        header.numEdges = numEdges_;
+        header.snapshotId = newSnapshotId();
+
+        uint64_t offset = alignUp(sizeof(SnapshotHeader));
+        for (size_t i = 0; i < pending_.size(); ++i) {
+            header.sections[i] = SnapshotSection{static_cast<uint32_t>(pending_[i].kind), pending_[i].elementSize, offset,
+                                                 pending_[i].bytes};
+            offset = alignUp(offset + pending_[i].bytes);
+        }
+
+        static const char padding[kSnapshotAlignment] = {};
+        uint64_t written = sizeof(SnapshotHeader);
+        sink(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (size_t i = 0; i < pending_.size(); ++i) {
+            sink(padding, header.sections[i].offset - written);
+            sink(pending_[i].data, pending_[i].bytes);
+            written = header.sections[i].offset + pending_[i].bytes;
+        }
+        sink(padding, alignUp(written) - written);
+    }
+
+    static uint64_t alignUp(uint64_t offset) { return (offset + kSnapshotAlignment - 1) / kSnapshotAlignment * kSnapshotAlignment; }
+
+    uint64_t numNodes_;
+    uint64_t numEdges_;
+    std::vector<Pending> pending_;
+    std::vector<std::vector<char>> owned_;
+};
+
+// Adds the paper id sections for vertices 0..numNodes-1. packed holds 20 bytes per vertex;
+// otherIds lists the vertices whose id could not be packed.
+template <typename OtherIds>
+void addPaperIdSections(GraphSnapshotWriter& writer, uint32_t numNodes, const uint8_t* packed, const OtherIds& otherIds) {
+    const size_t width = PaperIdDictionary::kPackedLength;
+    writer.add(SectionKind::PaperIdsPacked, packed, static_cast<size_t>(numNodes) * width, width);
+
+    std::vector<char> other;
+    std::vector<bool> isOther(numNodes, false);
+    for (const auto& entry : otherIds) {
+        uint32_t header[2] = {entry.first, static_cast<uint32_t>(entry.second.size())};
+        other.insert(other.end(), reinterpret_cast<const char*>(header), reinterpret_cast<const char*>(header + 2));
+        other.insert(other.end(), entry.second.begin(), entry.second.end());
+        other.resize((other.size() + 3) / 4 * 4, '\0');
+        isOther[entry.first] = true;
+    }
+    writer.addOwned(SectionKind::PaperIdsOther, std::move(other));
+
+    std::vector<uint32_t> index;
+    index.reserve(numNodes);
+    for (uint32_t v = 0; v < numNodes; ++v) {
+        if (!isOther[v]) index.push_back(v);
+    }
+    std::sort(index.begin(), index.end(), [&](uint32_t a, uint32_t b) {
+        return std::memcmp(packed + static_cast<size_t>(a) * width, packed + static_cast<size_t>(b) * width, width) < 0;
+    });
+    writer.addOwned(SectionKind::PaperIdIndex, std::move(index));
+}
+
+// Adds the component ranks, the component DAG and its GRAIL labels (reachability.h).
+inline ReachabilityIndexStats addReachabilitySections(GraphSnapshotWriter& writer, const CsrView& out) {
+    ReachabilityIndexData index = buildReachabilityIndex(out);
+    writer.addOwned(SectionKind::ComponentRank, std::move(index.componentRanks));
+    writer.addOwned(SectionKind::ComponentDagOffsets, std::move(index.dag.offsets));
+    writer.addOwned(SectionKind::ComponentDagTargets, std::move(index.dag.neighbors));
+    writer.addOwned(SectionKind::GrailLabels, std::move(index.labels));
+    return index.stats;
+}
+
+// Adds the landmark distance oracle (landmarks.h) with up to count landmarks.
+template <typename Ranks>
+LandmarkIndexStats addLandmarkSections(GraphSnapshotWriter& writer, const CsrView& out, const CsrView& in, const Ranks& pageRanks,
+                                       unsigned count, LandmarkSelection selection) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> landmarks = selectLandmarks(out, in, pageRanks, count, selection);
+    std::vector<uint8_t> distances = landmarkDistances(out, in, landmarks);
+    LandmarkIndexStats stats;
+    stats.landmarks = static_cast<unsigned>(landmarks.size());
+    stats.bytes = landmarks.size() * sizeof(uint32_t) + distances.size();
+    writer.addOwned(SectionKind::Landmarks, std::move(landmarks));
+    writer.addOwned(SectionKind::LandmarkDistances, std::move(distances));
+    stats.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+// Adds the best-first copies of the adjacency rows: cited papers by PageRank, citation count
+// and year, citing papers by PageRank and citation count.
+template <typename Ranks>
+void addRankedAdjacencySections(GraphSnapshotWriter& writer, const CsrView& out, const CsrView& in, const std::vector<int>& years,
+                                const std::vector<int>& citationCounts, const Ranks& pageRanks) {
+    writer.addOwned(SectionKind::OutByPageRank, rankNeighbors(out, pageRanks));
+    writer.addOwned(SectionKind::OutByCitationCount, rankNeighbors(out, citationCounts));
+    writer.addOwned(SectionKind::OutByYear, rankNeighbors(out, years));
+    writer.addOwned(SectionKind::InByPageRank, rankNeighbors(in, pageRanks));
+    writer.addOwned(SectionKind::InByCitationCount, rankNeighbors(in, citationCounts));
+}
+
+inline void addPaperTextSections(GraphSnapshotWriter& writer, const PaperMetadataStore& metadata) {
+    writer.add(SectionKind::TextEntries, metadata.entries());
+    writer.add(SectionKind::TextArena, metadata.arena().data(), metadata.arena().size(), 1);
+}
+
+// Read side: either a memory-mapped snapshot file or an in-memory image.
+class GraphSnapshot {
+public:
+    static constexpr uint32_t kNotFound = UINT32_MAX;
+
+    GraphSnapshot() = default;
+
+    static GraphSnapshot open(const std::string& filename) {
+        GraphSnapshot snapshot;
+        snapshot.file_ = MappedFile(filename);
+        snapshot.bind(snapshot.file_.data(), snapshot.file_.size(), filename);
+        return snapshot;
+    }
+
+    static GraphSnapshot fromImage(std::vector<char> image) {
+        GraphSnapshot snapshot;
+        snapshot.image_ = std::move(image);
+        snapshot.bind(snapshot.image_.data(), snapshot.image_.size(), "<memory>");
+        return snapshot;
+    }
+
+    static bool isSnapshotFile(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        char magic[sizeof(kSnapshotMagic)] = {};
+        in.read(magic, sizeof(magic));
+        return in && std::memcmp(magic, kSnapshotMagic, sizeof(magic)) == 0;
+    }
+
+    // snapshotId stored in a snapshot file without mapping it; 0 when it is not one
+    static uint64_t fileSnapshotId(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        SnapshotHeader header;
+        if (!in.read(reinterpret_cast<char*>(&header), offsetof(SnapshotHeader, reserved)) ||
+            std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+            return 0;
+        }
+        return header.snapshotId;
+    }
+
+    uint32_t numNodes() const { return static_cast<uint32_t>(header_->numNodes); }
+    uint64_t numEdges() const { return header_->numEdges; }
+    // As read when the file was mapped; snapshot files are only ever replaced, never patched
+    uint64_t snapshotId() const { return snapshotId_; }
+    uint32_t version() const { return header_->version; }
+    bool contains(long long v) const { return v >= 0 && v < static_cast<long long>(numNodes()); }
+
+    // Edges point from the citing paper to the cited paper
+    const CsrView& out() const { return out_; }
+    const CsrView& in() const { return in_; }
+    ArrayView<uint32_t> outEdges(uint32_t v) const { return out_.neighborsOf(v); }
+    ArrayView<uint32_t> inEdges(uint32_t v) const { return in_.neighborsOf(v); }
+    uint32_t outDegree(uint32_t v) const { return out_.degree(v); }
+    uint32_t inDegree(uint32_t v) const { return in_.degree(v); }
+
+    int year(uint32_t v) const { return years_[v]; }
+    int citationCount(uint32_t v) const { return citationCounts_[v]; }
+    double pageRank(uint32_t v) const { return pageRanks_[v]; }
+    ArrayView<int32_t> years() const { return years_; }
+    ArrayView<int32_t> citationCounts() const { return citationCounts_; }
+    ArrayView<double> pageRanks() const { return pageRanks_; }
+
+    // Vertex ids are build order unless main relabeled them (--reorder); this maps back.
+    bool reordered() const { return !originalVertices_.empty(); }
+    uint32_t originalVertex(uint32_t v) const { return reordered() ? originalVertices_[v] : v; }
+
+    // u cites v => componentRank(u) >= componentRank(v); empty for snapshots written before it existed
+    ArrayView<uint32_t> componentRanks() const { return componentRanks_; }
+    // Only the topological test when the snapshot has ranks but no DAG; empty without ranks
+    ReachabilityIndex reachability() const {
+        return ReachabilityIndex(componentRanks_, componentDag_, section<uint32_t>(SectionKind::GrailLabels));
+    }
+    // Hop-distance bounds; empty when the snapshot has no landmarks
+    LandmarkOracle landmarks() const {
+        ArrayView<uint32_t> landmarks = section<uint32_t>(SectionKind::Landmarks);
+        ArrayView<uint8_t> distances = section<uint8_t>(SectionKind::LandmarkDistances);
+        if (distances.size() != static_cast<size_t>(numNodes()) * 3 * landmarks.size()) return LandmarkOracle();
+        return LandmarkOracle(landmarks, distances);
+    }
+
+    // Cited (rankedOut) or citing (rankedIn) papers best first by ranking, sharing the offsets of
+    // out() / in(); None gives the plain rows. Empty (numNodes 0) when the snapshot has no such copy.
+    CsrView rankedOut(ChildRanking ranking) const {
+        if (ranking == ChildRanking::None) return out_;
+        if (ranking == ChildRanking::PageRank) return rankedView(out_, SectionKind::OutByPageRank);
+        if (ranking == ChildRanking::CitationCount) return rankedView(out_, SectionKind::OutByCitationCount);
+        if (ranking == ChildRanking::Year) return rankedView(out_, SectionKind::OutByYear);
+        return CsrView();
+    }
+    CsrView rankedIn(ChildRanking ranking) const {
+        if (ranking == ChildRanking::None) return in_;
+        if (ranking == ChildRanking::PageRank) return rankedView(in_, SectionKind::InByPageRank);
+        if (ranking == ChildRanking::CitationCount) return rankedView(in_, SectionKind::InByCitationCount);
+        return CsrView();
+    }
+
+    std::string_view title(uint32_t v) const { return text(v, 0); }
+    std::string_view abstract(uint32_t v) const { return text(v, 2); }
+    std::string url(uint32_t v) const {
+        std::string_view stored = text(v, 1);
+        if (!stored.empty()) return std::string(stored);
+        std::string id = paperId(v);
+        return id.empty() ? std::string() : kSemanticScholarUrl + id;
+    }
+
+    std::string paperId(uint32_t v) const {
+        auto it = std::lower_bound(otherIds_.begin(), otherIds_.end(), v,
+                                   [](const std::pair<uint32_t, std::string_view>& entry, uint32_t x) { return entry.first < x; });
+        if (it != otherIds_.end() && it->first == v) return std::string(it->second);
+        if (packedIds_.empty()) return std::string();
+        return PaperIdDictionary::unpack(packedIds_.data() + static_cast<size_t>(v) * PaperIdDictionary::kPackedLength);
+    }
+
+    // Vertex of a Semantic Scholar paper id, or kNotFound
+    uint32_t findPaper(std::string_view paperId) const {
+        uint8_t key[PaperIdDictionary::kPackedLength];
+        if (!PaperIdDictionary::pack(paperId, key)) {
+            for (const auto& entry : otherIds_) {
+                if (entry.second == paperId) return entry.first;
+            }
+            return kNotFound;
+        }
+        const size_t width = PaperIdDictionary::kPackedLength;
+        auto it = std::lower_bound(idIndex_.begin(), idIndex_.end(), key, [&](uint32_t v, const uint8_t* k) {
+            return std::memcmp(packedIds_.data() + static_cast<size_t>(v) * width, k, width) < 0;
+        });
+        if (it != idIndex_.end() && std::memcmp(packedIds_.data() + static_cast<size_t>(*it) * width, key, width) == 0) {
+            return *it;
+        }
+        return kNotFound;
+    }
+
+    bool hasSection(SectionKind kind) const { return findSection(kind) != nullptr; }
+
+    template <typename T>
+    ArrayView<T> section(SectionKind kind) const {
+        const SnapshotSection* s = findSection(kind);
+        if (!s) return ArrayView<T>();
+        return ArrayView<T>(reinterpret_cast<const T*>(base_ + s->offset), s->bytes / sizeof(T));
+    }
+
+private:
+    CsrView rankedView(const CsrView& plain, SectionKind kind) const {
+        ArrayView<uint32_t> ranked = section<uint32_t>(kind);
+        if (ranked.size() != numEdges()) return CsrView();
+        return CsrView{plain.offsets, ranked.data(), plain.numNodes};
+    }
+
+    const SnapshotSection* findSection(SectionKind kind) const {
+        for (uint32_t i = 0; i < header_->sectionCount; ++i) {
+            if (header_->sections[i].kind == static_cast<uint32_t>(kind)) return &header_->sections[i];
+        }
+        return nullptr;
+    }
+
+    template <typename T>
+    ArrayView<T> required(SectionKind kind, size_t count, const std::string& name) const {
+        ArrayView<T> values = section<T>(kind);
+        if (values.size() != count) {
+            throw std::runtime_error("Snapshot " + name + " is missing section " + std::to_string(static_cast<uint32_t>(kind)));
+        }
+        return values;
+    }
+
+    void bind(const char* base, size_t size, const std::string& name) {
+        if (size < sizeof(SnapshotHeader) || std::memcmp(base, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+            throw std::runtime_error("Not a graph snapshot: " + name);
+        }
+        base_ = base;
+        header_ = reinterpret_cast<const SnapshotHeader*>(base);
+        snapshotId_ = header_->snapshotId;
+        if (header_->version != kSnapshotVersion) {
+            throw std::runtime_error("Unsupported snapshot version " + std::to_string(header_->version) + " in " + name);
+        }
+        for (uint32_t i = 0; i < header_->sectionCount; ++i) {
+            const SnapshotSection& s = header_->sections[i];
+            if (header_->sectionCount > kMaxSnapshotSections || s.offset + s.bytes > size) {
+                throw std::runtime_error("Truncated snapshot: " + name);
+            }
+        }
+
+        size_t n = header_->numNodes;
+        size_t m = header_->numEdges;
+        out_ = CsrView{required<uint64_t>(SectionKind::OutOffsets, n + 1, name).data(),
+                       required<uint32_t>(SectionKind::OutTargets, m, name).data(), static_cast<uint32_t>(n)};
+        in_ = CsrView{required<uint64_t>(SectionKind::InOffsets, n + 1, name).data(),
+                      required<uint32_t>(SectionKind::InSources, m, name).data(), static_cast<uint32_t>(n)};
+        years_ = required<int32_t>(SectionKind::Year, n, name);
+        citationCounts_ = required<int32_t>(SectionKind::CitationCount, n, name);
+        pageRanks_ = required<double>(SectionKind::PageRank, n, name);
+        textEntries_ = section<PaperTextEntry>(SectionKind::TextEntries);
+        textArena_ = section<char>(SectionKind::TextArena);
+        packedIds_ = section<uint8_t>(SectionKind::PaperIdsPacked);
+        idIndex_ = section<uint32_t>(SectionKind::PaperIdIndex);
+        originalVertices_ = section<uint32_t>(SectionKind::OriginalVertex);
+        componentRanks_ = section<uint32_t>(SectionKind::ComponentRank);
+        if (componentRanks_.size() != n) componentRanks_ = ArrayView<uint32_t>();
+        ArrayView<uint64_t> dagOffsets = section<uint64_t>(SectionKind::ComponentDagOffsets);
+        ArrayView<uint32_t> dagTargets = section<uint32_t>(SectionKind::ComponentDagTargets);
+        if (!componentRanks_.empty() && !dagOffsets.empty() && dagOffsets[dagOffsets.size() - 1] == dagTargets.size()) {
+            componentDag_ = CsrView{dagOffsets.data(), dagTargets.data(), static_cast<uint32_t>(dagOffsets.size() - 1)};
+        }
+        if (!originalVertices_.empty() && originalVertices_.size() != n) {
+            throw std::runtime_error("Snapshot " + name + " has a vertex order of the wrong size");
+        }
+
+        ArrayView<char> other = section<char>(SectionKind::PaperIdsOther);
+        for (size_t pos = 0; pos + 8 <= other.size();) {
+            uint32_t record[2];
+            std::memcpy(record, other.data() + pos, sizeof(record));
+            otherIds_.emplace_back(record[0], std::string_view(other.data() + pos + 8, record[1]));
+            pos += (8 + record[1] + 3) / 4 * 4;
+        }
+        std::sort(otherIds_.begin(), otherIds_.end());
+    }
+
+    // field: 0 title, 1 url, 2 abstract
+    std::string_view text(uint32_t v, int field) const {
+        if (v >= textEntries_.size()) return std::string_view();
+        const PaperTextEntry& entry = textEntries_[v];
+        uint64_t offset = entry.offset;
+        if (field > 0) offset += entry.titleLength;
+        if (field > 1) offset += entry.urlLength;
+        uint32_t length = field == 0 ? entry.titleLength : field == 1 ? entry.urlLength : entry.abstractLength;
+        return std::string_view(textArena_.data() + offset, length);
+    }
+
+    MappedFile file_;
+    std::vector<char> image_;
+    const char* base_ = nullptr;
+    const SnapshotHeader* header_ = nullptr;
+    uint64_t snapshotId_ = 0;
+    CsrView out_;
+    CsrView in_;
+    ArrayView<int32_t> years_;
+    ArrayView<int32_t> citationCounts_;
+    ArrayView<double> pageRanks_;
+    ArrayView<PaperTextEntry> textEntries_;
+    ArrayView<char> textArena_;
+    ArrayView<uint8_t> packedIds_;
+    ArrayView<uint32_t> idIndex_;
+    ArrayView<uint32_t> originalVertices_;
+    ArrayView<uint32_t> componentRanks_;
+    CsrView componentDag_;
+    std::vector<std::pair<uint32_t, std::string_view>> otherIds_;
+};
+
+// A Semantic Scholar id, or a vertex id when no paper has that id; kNotFound otherwise
+inline uint32_t resolvePaper(const GraphSnapshot& graph, const std::string& id) {
+    uint32_t v = graph.findPaper(id);
+    if (v != GraphSnapshot::kNotFound) return v;
+    if (id.empty() || id.size() > 10 || id.find_first_not_of("0123456789") != std::string::npos) return GraphSnapshot::kNotFound;
+    unsigned long long vertex = std::stoull(id);
+    return vertex < graph.numNodes() ? static_cast<uint32_t>(vertex) : GraphSnapshot::kNotFound;
+}
+
+struct SnapshotSectionUpdate {
+    SectionKind kind;
+    const void* data;
+    size_t bytes;
+};
+
+// Replaces fixed-size sections of a snapshot file (e.g. PageRank after a separate ranking run)
+// and gives the snapshot a new snapshotId. The file is never changed in place: the patched copy
+// replaces it through replaceFile, as GraphSnapshotWriter writes it, so a reader that has the
+// file mapped (graph_server) sees all of the updates or none of them. With an output file name
+// the copy goes there and filename is left alone.
+inline void updateSnapshotSections(const std::string& filename, const std::vector<SnapshotSectionUpdate>& updates,
+                                   const std::string& output = "") {
+    MappedFile file(filename, MappedFile::CopyOnWrite);
+    if (file.size() < sizeof(SnapshotHeader) || std::memcmp(file.data(), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+        throw std::runtime_error("Not a graph snapshot: " + filename);
+    }
+    SnapshotHeader* header = reinterpret_cast<SnapshotHeader*>(file.data());
+    for (const SnapshotSectionUpdate& update : updates) {
+        const SnapshotSection* section = nullptr;
+        for (uint32_t i = 0; i < header->sectionCount && i < kMaxSnapshotSections; ++i) {
+            if (header->sections[i].kind == static_cast<uint32_t>(update.kind)) section = &header->sections[i];
+        }
+        if (!section) {
+            throw std::runtime_error("Section " + std::to_string(static_cast<uint32_t>(update.kind)) + " not found in " + filename);
+        }
+        if (section->bytes != update.bytes || section->offset + update.bytes > file.size()) {
+            throw std::runtime_error("Section size mismatch in " + filename);
+        }
+        std::memcpy(file.data() + section->offset, update.data, update.bytes);
+    }
+    header->snapshotId = newSnapshotId();
+
+    replaceFile(output.empty() ? filename : output, "snapshot file", [&](auto write) { write(file.data(), file.size()); });
+}
+
+// Writes new PageRank values into a snapshot file and re-sorts the PageRank-ordered adjacency
+// rows, if it has them, so they keep agreeing with the column. All of them are replaced at once:
+// new ranks never meet rows sorted by the old ones. output as for updateSnapshotSections.
+inline void updateSnapshotPageRank(const std::string& filename, const std::vector<double>& pageRanks,
+                                   const std::string& output = "") {
+    std::vector<SnapshotSectionUpdate> updates = {{SectionKind::PageRank, pageRanks.data(), pageRanks.size() * sizeof(double)}};
+    GraphSnapshot graph = GraphSnapshot::open(filename);
+    const std::pair<SectionKind, CsrView> ranked[] = {{SectionKind::OutByPageRank, graph.out()},
+                                                      {SectionKind::InByPageRank, graph.in()}};
+    std::vector<std::vector<uint32_t>> rows;
+    rows.reserve(2);
+    for (const auto& entry : ranked) {
+        if (!graph.hasSection(entry.first)) continue;
+        rows.push_back(rankNeighbors(entry.second, pageRanks));
+        updates.push_back({entry.first, rows.back().data(), rows.back().size() * sizeof(uint32_t)});
+    }
+    updateSnapshotSections(filename, updates, output);
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "csr_graph.h"
+#include "multi_source_bfs.h"
+#include "parallel.h"
+
+// Landmark (ALT) hop-distance oracle. A few central papers are landmarks; every vertex stores
+// its BFS distance from and to each landmark along citations and, ignoring direction, to it.
+// The triangle inequality then bounds the distance between any two papers in O(landmarks):
+//   d(L, t) - d(L, s) <= d(s, t) <= d(s, L) + d(L, t)   and   d(s, L) - d(t, L) <= d(s, t)
+// Distances are one byte; anything more than kMaxLandmarkDistance hops away is stored as
+// unreached, which no citation graph comes near.
+//
+// Layout: distances[v * 3 * k + j], j in [0, k) from landmark j, [k, 2k) to it, [2k, 3k) undirected.
+
+enum class LandmarkSelection { PageRank, Degree };
+
+const uint8_t kLandmarkUnreached = 255;
+const uint32_t kMaxLandmarkDistance = 254;
+const unsigned kDefaultLandmarks = 8;
+
+inline const char* landmarkSelectionName(LandmarkSelection selection) {
+    return selection == LandmarkSelection::Degree ? "degree" : "pagerank";
+}
+
+inline bool parseLandmarkSelection(const std::string& name, LandmarkSelection& selection) {
+    for (LandmarkSelection candidate : {LandmarkSelection::PageRank, LandmarkSelection::Degree}) {
+        if (name == landmarkSelectionName(candidate)) {
+            selection = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Highest scoring papers (PageRank, or citations plus references), skipping those next to an
+// earlier landmark so the landmarks cover different parts of the graph.
+template <typename Ranks>
+std::vector<uint32_t> selectLandmarks(const CsrView& out, const CsrView& in, const Ranks& pageRanks, unsigned count,
+                                      LandmarkSelection selection) {
+    const uint32_t n = out.numNodes;
+    std::vector<uint32_t> candidates(n);
+    std::iota(candidates.begin(), candidates.end(), 0u);
+    if (selection == LandmarkSelection::PageRank) {
+        std::stable_sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) { return pageRanks[a] > pageRanks[b]; });
+    } else {
+        std::stable_sort(candidates.begin(), candidates.end(), [&](uint32_t a, uint32_t b) {
+            return out.degree(a) + in.degree(a) > out.degree(b) + in.degree(b);
+        });
+    }
+    std::vector<uint32_t> landmarks;
+    std::vector<uint8_t> adjacent(n, 0);
+    for (uint32_t v : candidates) {
+        if (landmarks.size() == count) break;
+        if (adjacent[v] || out.degree(v) + in.degree(v) == 0) continue;
+        landmarks.push_back(v);
+        adjacent[v] = 1;
+        for (uint32_t u : out.neighborsOf(v)) adjacent[u] = 1;
+        for (uint32_t u : in.neighborsOf(v)) adjacent[u] = 1;
+    }
+    return landmarks;
+}
+
+struct LandmarkIndexStats {
+    unsigned landmarks = 0;
+    uint64_t bytes = 0;
+    double buildMs = 0.0;
+};
+
+// One multi-source BFS per direction for up to 64 landmarks at a time, run in parallel; each
+// landmark writes its own byte of every row.
+inline std::vector<uint8_t> landmarkDistances(const CsrView& out, const CsrView& in, const std::vector<uint32_t>& landmarks,
+                                              unsigned numThreads = defaultThreadCount()) {
+    using Engine = MultiSourceBfs<1>;
+    const size_t n = out.numNodes;
+    const size_t k = landmarks.size();
+    const size_t stride = 3 * k;
+    const size_t batches = (k + Engine::kBatch - 1) / Engine::kBatch;
+    std::vector<uint8_t> distances(n * stride, kLandmarkUnreached);
+    parallelFor(3 * batches, numThreads, [&](size_t task, unsigned) {
+        size_t direction = task / batches;  // from the landmarks, to them, ignoring direction
+        size_t begin = task % batches * Engine::kBatch;
+        std::vector<uint32_t> roots(landmarks.begin() + begin, landmarks.begin() + std::min(k, begin + Engine::kBatch));
+        Engine engine = direction == 0 ? Engine(out) : direction == 1 ? Engine(in) : Engine(out, in);
+        uint8_t* dist = distances.data() + direction * k + begin;
+        for (size_t s = 0; s < roots.size(); ++s) dist[roots[s] * stride + s] = 0;
+        engine.run(roots, std::vector<int>(roots.size(), kMaxLandmarkDistance), [&](uint32_t level, const std::vector<uint32_t>& reached) {
+            for (uint32_t u : reached) {
+                Engine::forEachSource(engine.reachedBits(u), [&](size_t s) { dist[u * stride + s] = static_cast<uint8_t>(level); });
+            }
+        });
+    });
+    return distances;
+}
+
+// lower is kNoPath when the landmarks prove there is no path, upper is kNoPath when no landmark
+// connects the two.
+struct DistanceBounds {
+    static constexpr uint32_t kNoPath = UINT32_MAX;
+    uint32_t lower = 0;
+    uint32_t upper = kNoPath;
+};
+
+// Bounds over the (memory-mapped) landmark distances; empty without them.
+class LandmarkOracle {
+public:
+    LandmarkOracle() = default;
+    LandmarkOracle(ArrayView<uint32_t> landmarks, ArrayView<uint8_t> distances) : landmarks_(landmarks), distances_(distances) {}
+
+    bool empty() const { return landmarks_.empty(); }
+    size_t numLandmarks() const { return landmarks_.size(); }
+    ArrayView<uint32_t> landmarks() const { return landmarks_; }
+
+    DistanceBounds bounds(uint32_t s, uint32_t t, bool undirected) const {
+        DistanceBounds bounds;
+        if (s == t) {
+            bounds.upper = 0;
+            return bounds;
+        }
+        const size_t k = landmarks_.size();
+        const uint8_t* a = distances_.data() + static_cast<size_t>(s) * 3 * k;
+        const uint8_t* b = distances_.data() + static_cast<size_t>(t) * 3 * k;
+        auto tighten = [&](uint32_t lower, uint32_t upper) {
+            bounds.lower = std::max(bounds.lower, lower);
+            bounds.upper = std::min(bounds.upper, upper);
+        };
+        const uint32_t kNoPath = DistanceBounds::kNoPath;
+        const uint8_t kFar = kLandmarkUnreached;
+        for (size_t j = 0; j < k; ++j) {
+            if (undirected) {
+                uint8_t ds = a[2 * k + j];
+                uint8_t dt = b[2 * k + j];
+                if ((ds == kFar) != (dt == kFar)) tighten(kNoPath, kNoPath);
+                if (ds != kFar && dt != kFar) tighten(ds > dt ? ds - dt : dt - ds, ds + dt);
+                continue;
+            }
+            uint8_t fromS = a[j], fromT = b[j], toS = a[k + j], toT = b[k + j];
+            // L reaches s but not t, or t reaches L but s does not: s cannot reach t
+            if (fromS != kFar) tighten(fromT == kFar ? kNoPath : (fromT > fromS ? fromT - fromS : 0), kNoPath);
+            if (toT != kFar) tighten(toS == kFar ? kNoPath : (toS > toT ? toS - toT : 0), kNoPath);
+            if (toS != kFar && fromT != kFar) tighten(0, toS + fromT);
+        }
+        if (bounds.lower == kNoPath) bounds.upper = kNoPath;
+        return bounds;
+    }
+
+private:
+    ArrayView<uint32_t> landmarks_;
+    ArrayView<uint8_t> distances_;
+};
@@ -3,18 +3,26 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
-#include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/graphviz.hpp>
 #include <rapidjson/document.h>
-#include <rapidjson/istreamwrapper.h>
-#include <thread>
-#include <mutex>
 #include <sstream>
+#include <string_view>
 #include <utility>
 #include <stdexcept>
 #include <sqlite3.h>
-#include <Eigen/Sparse>
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include "csr_graph.h"
+#include "csv_reader.h"
+#include "graph_snapshot.h"
+#include "mapped_file.h"
+#include "pagerank_batch.h"
+#include "pagerank_engine.h"
+#include "paper_columns.h"
+#include "paper_id_dictionary.h"
+#include "parallel.h"
+#include "vertex_order.h"
 
 using namespace rapidjson;
 using namespace boost;
@@ -26,78 +34,29 @@ const int MAX_ITERATIONS = 100;
 const double CONVERGENCE_THRESHOLD = 1e-9;
 const double MIN_DANGLING_CONTRIBUTION = 1e-9;
 
-// Define custom property tags for vertex properties
-struct VertexProperties {
-    string name;
-    string url;
-    string id;
-    int centrality;
-    int year;
-    string abstract;
-};
+// Define the graph type. Vertices are the dense ids handed out by paper_ids; vertex
+// attributes live in paper_columns (hot) and paper_metadata (cold). Edges go from the
+// citing paper to the cited paper.
+typedef CsrGraph Graph;
+typedef uint32_t Vertex;
 
-// Define the graph type
-typedef adjacency_list<vecS, vecS, directedS, VertexProperties> Graph;
-typedef graph_traits<Graph>::vertex_descriptor Vertex;
-
-// Struct to store paper information
-struct PaperInfo {
-    string title;
-    string url;
-    string id;
-    int year;
-    int citationCount;
-    string abstract; // Added abstract field
-};
+const string SEMANTIC_SCHOLAR_URL = "https://www.semanticscholar.org/paper/";
 
 // Global variables
-mutex mtx;
-std::unordered_map<string, Vertex> node_map;
-std::unordered_map<string, PaperInfo> paper_info_map;
+PaperIdDictionary paper_ids;
+PaperColumns paper_columns;
+PaperMetadataStore paper_metadata;
+// Citations as packed (citing, cited) pairs, turned into g once all input is read
+vector<uint64_t> citation_edges;
 Graph g;
+// Build-order id of every vertex when --reorder relabeled the graph, empty otherwise
+vector<uint32_t> original_vertex;
 int csv_lines_processed = 0;
 int csv_lines_skipped = 0;
 int json_lines_processed = 0;
 int json_lines_skipped = 0;
 int citing_nodes_created = 0;
 
-std::string ReplaceAll(std::string str, const std::string& from, const std::string& to) {
-    size_t start_pos = 0;
-    while((start_pos = str.find(from, start_pos)) != std::string::npos) {
-        str.replace(start_pos, from.length(), to);
-        start_pos += to.length();
-    }
-    return str;
-}
-
-vector<string> split_csv_line(const string& line) {
-    vector<string> result;
-    stringstream ss(line);
-    string item;
-    bool in_quotes = false;
-    string temp;
-    
-    while (getline(ss, item, ',')) {
-        if (in_quotes) {
-            temp += ',' + item;
-            if (!item.empty() && item.back() == '"') {
-                result.push_back(temp.substr(1, temp.size() - 2));
-                in_quotes = false;
-            }
-        } else {
-            if (!item.empty() && item.front() == '"' && item.back() != '"') {
-                temp = item;
-                in_quotes = true;
-            } else if (!item.empty() && item.front() == '"' && item.back() == '"') {
-                result.push_back(item.substr(1, item.size() - 2));
-            } else {
-                result.push_back(item);
-            }
-        }
-    }
-    return result;
-}
-
 string escape_dot_string(const string& str) {
     string escaped = str;
     size_t pos = 0;
@@ -108,62 +67,148 @@ string escape_dot_string(const string& str) {
     return escaped;
 }
 
+// Papers known only from the JSONL get their Semantic Scholar url derived on export
+string paper_url(Vertex v) {
+    string_view url = paper_metadata.url(v);
+    return url.empty() ? SEMANTIC_SCHOLAR_URL + paper_ids.id(v) : string(url);
+}
+
 void load_paper_info(const string& csv_filename) {
-    ifstream file(csv_filename);
-    if (!file.is_open()) {
+    MappedFile file;
+    try {
+        file = MappedFile(csv_filename, MappedFile::CopyOnWrite);
+    } catch (const std::runtime_error& e) {
         cerr << "Error opening file: " << csv_filename << endl;
         return;
     }
-
-    string line;
-    getline(file, line); // Skip header
-
-    while (getline(file, line)) {
-        vector<string> fields = split_csv_line(line);
+    file.adviseSequential();
+
+    // Quoted fields are unescaped in place, so messages quote the untouched file
+    MappedFile original;
+    CsvReader reader(file.data(), file.size());
+    auto current_row = [&]() {
+        if (original.empty()) original = MappedFile(csv_filename);
+        string_view row(original.data() + reader.rowBegin(), reader.rowEnd() - reader.rowBegin());
+        while (!row.empty() && (row.back() == '\n' || row.back() == '\r')) row.remove_suffix(1);
+        return row;
+    };
+
+    vector<string_view> fields;
+    reader.nextRow(fields); // Skip header
+
+    while (reader.nextRow(fields)) {
         if (fields.size() < 6) {  // Adjusted number of expected columns
-            cerr << "Skipping malformed line: " << line << endl;
+            cerr << "Skipping malformed line: " << current_row() << endl;
             csv_lines_skipped++;
             continue;
         }
 
-        string paperId = fields[0];
-        string url = fields[1];
-        string title_old = escape_dot_string(fields[2]);
-        // TODO: replacing "" in paper names with nothing because some paper are being missed this way
-        string title = ReplaceAll(title_old, std::string("\"\""), std::string(" "));
-        string year = fields[3];
-        string citationCount = fields[4];
-        string abstract_old = fields[5];
-        string abstract = ReplaceAll(abstract_old, std::string("\n"), std::string(" "));
+        string_view paperId = fields[0];
+        string title = escape_dot_string(string(fields[2]));
+        string year(fields[3]);
+        string citationCount(fields[4]);
+        // Abstracts may span several lines inside their quotes
+        string abstract(fields[5]);
+        std::replace(abstract.begin(), abstract.end(), '\n', ' ');
+        std::replace(abstract.begin(), abstract.end(), '\r', ' ');
 
         try {
             int yearInt = stoi(year);
             int citationCountInt = stoi(citationCount);
-            PaperInfo info = {title, url, paperId, yearInt, citationCountInt, abstract};
-            paper_info_map[paperId] = info;
-
-            // Add node to graph
-            Vertex v = add_vertex(g);
-            node_map[paperId] = v;
-            g[v].name = title;
-            g[v].url = url;
-            g[v].id = paperId; 
-            g[v].centrality = citationCountInt;
-            g[v].year = yearInt;
-            g[v].abstract = abstract; // Store abstract in vertex properties
+            // A repeated paperId updates its existing vertex
+            bool inserted;
+            Vertex v = paper_ids.intern(paperId, &inserted);
+            if (inserted) {
+                paper_columns.add(yearInt, citationCountInt);
+            } else {
+                paper_columns.year[v] = yearInt;
+                paper_columns.citationCount[v] = citationCountInt;
+            }
+            paper_metadata.set(v, title, fields[1], abstract);
             csv_lines_processed++;
         } catch (const std::invalid_argument& e) {
-            cerr << "Invalid argument: " << e.what() << " in line: " << line << endl;
+            cerr << "Invalid argument: " << e.what() << " in line: " << current_row() << endl;
             csv_lines_skipped++;
             continue;
         } catch (const std::out_of_range& e) {
-            cerr << "Out of range: " << e.what() << " in line: " << line << endl;
+            cerr << "Out of range: " << e.what() << " in line: " << current_row() << endl;
             csv_lines_skipped++;
             continue;
         }
     }
+}
+
+// One reference line. The string fields point into the buffer the line was parsed from.
+struct ReferenceRecord {
+    string_view citing_paper_id;
+    string_view cited_paper_id;
+    string_view cited_paper_title;
+    int cited_paper_year;
+    int cited_paper_citations;
+    string_view cited_paper_abstract;
+};
+
+string_view json_string_or(const Value& obj, const char* name, string_view fallback) {
+    auto itr = obj.FindMember(name);
+    if (itr == obj.MemberEnd() || !itr->value.IsString()) return fallback;
+    return string_view(itr->value.GetString(), itr->value.GetStringLength());
+}
+
+int json_int_or(const Value& obj, const char* name, int fallback) {
+    auto itr = obj.FindMember(name);
+    return itr != obj.MemberEnd() && itr->value.IsInt() ? itr->value.GetInt() : fallback;
+}
+
+// Returns false for lines that should be counted as malformed.
+bool extract_reference(const Document& d, ReferenceRecord& record) {
+    if (d.HasParseError() || !d.IsObject()) return false;
+
+    // Get citingPaperId
+    auto citingPaperIdItr = d.FindMember("citingPaperId");
+    if (citingPaperIdItr == d.MemberEnd() || !citingPaperIdItr->value.IsString()) return false;
+    record.citing_paper_id = string_view(citingPaperIdItr->value.GetString(), citingPaperIdItr->value.GetStringLength());
+
+    // Get citedPaper object
+    auto citedPaperItr = d.FindMember("citedPaper");
+    if (citedPaperItr == d.MemberEnd() || !citedPaperItr->value.IsObject()) return false;
+    const Value& citedPaper = citedPaperItr->value;
+
+    // Extract citedPaper fields
+    record.cited_paper_id = json_string_or(citedPaper, "paperId", "unknown");
+    record.cited_paper_title = json_string_or(citedPaper, "title", "unknown");
+    record.cited_paper_year = json_int_or(citedPaper, "year", 0);
+    record.cited_paper_citations = json_int_or(citedPaper, "citationCount", 0);
+    record.cited_paper_abstract = json_string_or(citedPaper, "abstract", "");
+    return true;
+}
+
+// Adds the edge for one reference, creating vertices for papers seen for the first time.
+void add_citation(const ReferenceRecord& record) {
+    bool inserted;
+    Vertex cited = paper_ids.intern(record.cited_paper_id, &inserted);
+    if (inserted) {
+        // If the cited paper is not in the initial set, add it as an isolated node
+        paper_columns.add(record.cited_paper_year, record.cited_paper_citations);
+        // Cited titles have always gone through boost's escaping (quoted when not a plain DOT id)
+        string abstract(record.cited_paper_abstract);
+        std::replace(abstract.begin(), abstract.end(), '\n', ' ');
+        paper_metadata.set(cited, boost::escape_dot_string(string(record.cited_paper_title)), "", abstract);
+    }
+    Vertex citing = paper_ids.intern(record.citing_paper_id, &inserted);
+    if (inserted) {
+        // If the citing paper is not in the initial set, add it as an isolated node
+        paper_columns.add(0, 0);
+        paper_metadata.set(citing, record.citing_paper_id, "", "");
+        citing_nodes_created++;
+    }
+
+    citation_edges.push_back(packEdge(citing, cited));
+
+    if (json_lines_processed % 100000 == 0) {
+        cout << "Json lines processed: " << json_lines_processed << endl;
+    }
 
-    file.close();
+    json_lines_processed++;
 }
 
 void parse_jsonl_file(const string& filename) {
@@ -173,198 +218,359 @@ void parse_jsonl_file(const string& filename) {
         return;
     }
 
-    IStreamWrapper isw(ifs);
     string line;
     while (getline(ifs, line)) {
         Document d;
         d.Parse(line.c_str());
 
-        if (!d.IsObject()) {
+        ReferenceRecord record;
+        if (!extract_reference(d, record)) {
             cerr << "Skipping malformed JSON line: " << line << endl;
             json_lines_skipped++;
             continue;
         }
+        add_citation(record);
+    }
 
-        // Get citingPaperId
-        auto citingPaperIdItr = d.FindMember("citingPaperId");
-        if (citingPaperIdItr == d.MemberEnd() || !citingPaperIdItr->value.IsString()) {
-            cerr << "Skipping malformed JSON line: " << line << endl;
-            json_lines_skipped++;
-            continue;
-        }
-        string citing_paper_id = citingPaperIdItr->value.GetString();
+    ifs.close();
+}
 
-        // Get citedPaper object
-        auto citedPaperItr = d.FindMember("citedPaper");
-        if (citedPaperItr == d.MemberEnd() || !citedPaperItr->value.IsObject()) {
-            cerr << "Skipping malformed JSON line: " << line << endl;
-            json_lines_skipped++;
-            continue;
-        }
-        const Value& citedPaper = citedPaperItr->value;
+// Parsed references of one newline-aligned slice of the JSONL file.
+struct JsonlChunk {
+    size_t begin;
+    size_t end;
+    vector<ReferenceRecord> records;
+    vector<pair<size_t, size_t>> malformed_lines; // (offset, length) in the file
+    string last_line; // copy of an unterminated final line, which has no room for the in-situ '\0'
+};
 
-        // Extract citedPaper fields
-        string cited_paper_id = citedPaper.HasMember("paperId") && citedPaper["paperId"].IsString() ? citedPaper["paperId"].GetString() : "unknown";
-        string cited_paper_title = citedPaper.HasMember("title") && citedPaper["title"].IsString() ? escape_dot_string(citedPaper["title"].GetString()) : "unknown";
-        int cited_paper_year = citedPaper.HasMember("year") && citedPaper["year"].IsInt() ? citedPaper["year"].GetInt() : 0;
-        int cited_paper_citations = citedPaper.HasMember("citationCount") && citedPaper["citationCount"].IsInt() ? citedPaper["citationCount"].GetInt() : 0;
-        string cited_paper_abstract_old = citedPaper.HasMember("abstract") && citedPaper["abstract"].IsString() ? citedPaper["abstract"].GetString() : "";
-        string cited_paper_abstract = ReplaceAll(cited_paper_abstract_old, std::string("\n"), std::string(" "));
+void parse_jsonl_chunk(char* data, JsonlChunk& chunk, vector<char>& value_buffer) {
+    MemoryPoolAllocator<> value_allocator(value_buffer.data(), value_buffer.size());
+    Document d(&value_allocator);
 
-        string url_start = "https://www.semanticscholar.org/paper/";
+    size_t pos = chunk.begin;
+    while (pos < chunk.end) {
+        char* line = data + pos;
+        char* newline = static_cast<char*>(memchr(line, '\n', chunk.end - pos));
+        size_t length = newline ? newline - line : chunk.end - pos;
 
-        
-        
-        lock_guard<mutex> lock(mtx);
-        if (node_map.find(cited_paper_id) == node_map.end()) {
-            // If the cited paper is not in the initial set, add it as an isolated node
-            Vertex v = add_vertex(g);
-            node_map[cited_paper_id] = v;
-            g[v].name = cited_paper_title;
-            g[v].url = url_start + cited_paper_id;
-            g[v].centrality = cited_paper_citations;
-            g[v].year = cited_paper_year;
-            g[v].abstract = cited_paper_abstract; 
-            g[v].id = cited_paper_id; 
-        }
-        if (node_map.find(citing_paper_id) == node_map.end()) {
-            // If the citing paper is not in the initial set, add it as an isolated node
-            Vertex v = add_vertex(g);
-            node_map[citing_paper_id] = v;
-            g[v].name = citing_paper_id;
-            g[v].url = url_start + citing_paper_id;
-            g[v].centrality = 0;
-            g[v].year = 0;
-            g[v].abstract = "";
-            g[v].id = citing_paper_id;
-            citing_nodes_created++;
+        if (newline) {
+            *newline = '\0';
+        } else {
+            // Only possible for the last line of the file
+            chunk.last_line.assign(line, length);
+            line = &chunk.last_line[0];
         }
 
-        // if ((node_map[citing_paper_id]["year"] - node_map[cited_paper_id]["year"]  == 1) || (node_map[citing_paper_id]["year"] - node_map[cited_paper_id]["year"]   == 0)) {
-        
-        add_edge(node_map[citing_paper_id], node_map[cited_paper_id], g);
-        // add_edge(node_map[cited_paper_id], node_map[citing_paper_id], g);
+        value_allocator.Clear();
+        d.ParseInsitu(line);
 
-        
-
-        if (json_lines_processed % 100000 == 0) {
-            cout << "Json lines processed: " << json_lines_processed << endl;
+        ReferenceRecord record;
+        if (extract_reference(d, record)) {
+            chunk.records.push_back(record);
+        } else {
+            chunk.malformed_lines.emplace_back(pos, length);
         }
-
-        json_lines_processed++;
+        pos += length + 1;
     }
-
-    ifs.close();
 }
 
-// Custom property writer for vertex properties
-class VertexPropertyWriter {
-public:
-    VertexPropertyWriter(Graph& g) : g(g) {}
-
-    template <class VertexOrEdge>
-    void operator()(ostream& out, const VertexOrEdge& v) const {
-        out << "[label=\"" << g[v].name << "\"";
-        out << ", year=\"" << g[v].year << "\"";
-        out << ", citationCount=\"" << g[v].centrality << "\"";
-        out << ", url=\"" << g[v].url << "\"";
-        out << ", id=\"" << g[v].id << "\"";
-        out << ", abstract=\"" << escape_dot_string(g[v].abstract) << "\"";
-        out << "]";
+// Memory-maps the JSONL file and parses newline-aligned chunks on all threads with
+// in-situ parsing. Each thread fills its own record buffer; buffers are then merged in
+// file order, so vertex numbering, counters and messages match parse_jsonl_file.
+void parse_jsonl_file_parallel(const string& filename, unsigned num_threads) {
+    MappedFile file;
+    try {
+        file = MappedFile(filename, MappedFile::CopyOnWrite);
+    } catch (const std::runtime_error& e) {
+        cerr << e.what() << endl;
+        return;
     }
+    file.adviseSequential();
+
+    // Work in rounds of num_threads chunks so record buffers stay bounded
+    const size_t chunk_bytes = 64 << 20;
+    size_t num_chunks = max<size_t>(num_threads, file.size() / chunk_bytes + 1);
+    vector<pair<size_t, size_t>> ranges = splitAtNewlines(file.data(), file.size(), num_chunks);
+    vector<vector<char>> value_buffers(num_threads, vector<char>(1 << 16));
+    MappedFile original; // unmodified view, only mapped to print malformed lines
+
+    for (size_t round_begin = 0; round_begin < ranges.size(); round_begin += num_threads) {
+        size_t round_size = min<size_t>(num_threads, ranges.size() - round_begin);
+        vector<JsonlChunk> chunks(round_size);
+        for (size_t i = 0; i < round_size; ++i) {
+            chunks[i].begin = ranges[round_begin + i].first;
+            chunks[i].end = ranges[round_begin + i].second;
+        }
 
-private:
-    Graph& g;
-};
+        parallelFor(round_size, num_threads, [&](size_t i, unsigned thread) {
+            parse_jsonl_chunk(file.data(), chunks[i], value_buffers[thread]);
+        });
 
+        for (const JsonlChunk& chunk : chunks) {
+            if (!chunk.malformed_lines.empty() && original.empty()) {
+                original = MappedFile(filename);
+            }
+            for (const auto& malformed : chunk.malformed_lines) {
+                cerr << "Skipping malformed JSON line: " << string_view(original.data() + malformed.first, malformed.second) << endl;
+                json_lines_skipped++;
+            }
+            for (const ReferenceRecord& record : chunk.records) {
+                add_citation(record);
+            }
+        }
+    }
+}
 
-void calculate_pagerank(const Graph& g, std::unordered_map<string, double>& pageRanks) {
-    int numNodes = num_vertices(g);
-    vector<Eigen::Triplet<double>> tripletList;
-    std::unordered_map<Vertex, int> idMapping;
-    
-    // Create ID mapping
-    int index = 0;
-    graph_traits<Graph>::vertex_iterator vi, vi_end;
-    for (tie(vi, vi_end) = vertices(g); vi != vi_end; ++vi) {
-        idMapping[*vi] = index++;
-    }
-
-    // Build triplet list (equivalent to original implementation)
-    graph_traits<Graph>::edge_iterator ei, ei_end;
-    for (tie(ei, ei_end) = edges(g); ei != ei_end; ++ei) {
-        Vertex source = boost::source(*ei, g);
-        Vertex target = boost::target(*ei, g);
-        tripletList.emplace_back(idMapping[source], idMapping[target], 1.0);
-    }
-
-    // Create sparse matrix
-    Eigen::SparseMatrix<double> adjacencyMatrix(numNodes, numNodes);
-    adjacencyMatrix.setFromTriplets(tripletList.begin(), tripletList.end());
-
-    // Find max citations for normalization
-    int maxCitations = 0;
-    for (tie(vi, vi_end) = vertices(g); vi != vi_end; ++vi) {
-        maxCitations = max(maxCitations, g[*vi].centrality);
-    }
-
-    // Initialize ranks with citation count bias (matching original)
-    Eigen::VectorXd ranks(numNodes);
-    for (tie(vi, vi_end) = vertices(g); vi != vi_end; ++vi) {
-        int mappedId = idMapping[*vi];
-        double normalizedCitation = log(g[*vi].centrality + 1) / log(maxCitations + 1);
-        ranks[mappedId] = normalizedCitation;
-    }
-    ranks /= ranks.sum();
-
-    // Identify dangling nodes (matching original)
-    Eigen::VectorXd danglingNodes = Eigen::VectorXd::Zero(numNodes);
-    for (tie(vi, vi_end) = vertices(g); vi != vi_end; ++vi) {
-        int mappedId = idMapping[*vi];
-        if (out_degree(*vi, g) == 0) {
-            danglingNodes[mappedId] = 1.0;
+// Writes the graph in the layout boost::write_graphviz used to produce
+void write_dot_file(const Graph& g, const string& outputPath) {
+    ofstream out(outputPath);
+    out << "digraph G {" << endl;
+    for (Vertex v = 0; v < g.numNodes(); ++v) {
+        out << v << "[label=\"" << paper_metadata.title(v) << "\"";
+        out << ", year=\"" << paper_columns.year[v] << "\"";
+        out << ", citationCount=\"" << paper_columns.citationCount[v] << "\"";
+        out << ", url=\"" << paper_url(v) << "\"";
+        out << ", id=\"" << paper_ids.id(v) << "\"";
+        out << ", abstract=\"" << escape_dot_string(string(paper_metadata.abstract(v))) << "\"";
+        out << "];" << endl;
+    }
+    for (Vertex v = 0; v < g.numNodes(); ++v) {
+        for (Vertex cited : g.view().neighborsOf(v)) {
+            out << v << "->" << cited << " ;" << endl;
         }
     }
+    out << "}" << endl;
+}
 
-    // PageRank iteration (matching original implementation)
-    Eigen::VectorXd oldRanks(numNodes);
-    for (int iteration = 0; iteration < MAX_ITERATIONS; ++iteration) {
-        oldRanks = ranks;
-        double danglingContribution = MIN_DANGLING_CONTRIBUTION * danglingNodes.sum();
-        Eigen::VectorXd newRanks = DAMPING_FACTOR * (adjacencyMatrix * oldRanks + 
-            danglingContribution * Eigen::VectorXd::Ones(numNodes)) + 
-            (1 - DAMPING_FACTOR) / numNodes * Eigen::VectorXd::Ones(numNodes);
+// Command line switches for main
+struct BuildOptions {
+    bool parallel_jsonl = false;
+    unsigned threads = defaultThreadCount();
+    bool float_pagerank = false;   // float32 ranks with the SIMD gather kernel
+    bool pagerank_report = false;  // also solve with the baseline (or float) setup and print the drift
+    SimdLevel simd = SimdLevel::Auto;
+    PageRankSolver solver = PageRankSolver::Power;
+    string previous_snapshot;      // --incremental: warm start PageRank from this snapshot
+    string delta_references;       // --delta-references: only these references are parsed, the rest come from previous_snapshot
+    vector<RankingVariant> rankings;  // --ranking: extra rank columns, solved together in one batch
+    VertexOrder vertex_order = VertexOrder::Original;
+    unsigned landmarks = kDefaultLandmarks;  // --landmarks: distance oracle size in the snapshot, 0 = none
+    LandmarkSelection landmark_selection = LandmarkSelection::PageRank;
+    bool ranked_adjacency = true;  // --no-ranked-adjacency: leave the best-first rows out of the snapshot
+};
 
-        newRanks /= newRanks.sum();
-        double diff = (newRanks - oldRanks).norm();
+// Values of the --ranking variants, one column per variant in flag order
+struct RankingColumns {
+    vector<string> names;
+    vector<vector<double>> values;
+};
+
+// What changed since the snapshot an incremental run starts from
+struct IncrementalStats {
+    uint32_t previous_nodes = 0;
+    uint64_t previous_edges = 0;
+    uint32_t carried_over = 0;     // papers present in both, matched by paper id
+    uint32_t new_papers = 0;
+    uint64_t new_citations = 0;
+    uint64_t dropped_citations = 0;
+};
 
-        if (iteration % 1 == 0) {
-            cout << "Iteration " << iteration << ": diff = " << diff << endl;
+// Delta ingest for an incremental run: the citations of the previous snapshot are taken as they are and
+// only the new references get parsed. Papers the CSV does not list are added back in their build order, so
+// the vertices are numbered as by a full run over the old references followed by the new ones.
+bool load_previous_citations(const string& snapshotPath) {
+    GraphSnapshot previous;
+    try {
+        previous = GraphSnapshot::open(snapshotPath);
+    } catch (const runtime_error& e) {
+        cerr << "Delta ingest: cannot use " << snapshotPath << " (" << e.what() << "), reading all references" << endl;
+        return false;
+    }
+    vector<uint32_t> by_build_order(previous.numNodes());
+    for (uint32_t pv = 0; pv < previous.numNodes(); ++pv) by_build_order[previous.originalVertex(pv)] = pv;
+
+    vector<Vertex> to_current(previous.numNodes());
+    uint32_t papers_added = 0;
+    for (uint32_t pv : by_build_order) {
+        bool inserted;
+        Vertex v = paper_ids.intern(previous.paperId(pv), &inserted);
+        if (inserted) {
+            // Like papers first seen in the references, these get their url derived on export
+            paper_columns.add(previous.year(pv), previous.citationCount(pv));
+            paper_metadata.set(v, previous.title(pv), "", previous.abstract(pv));
+            ++papers_added;
         }
+        to_current[pv] = v;
+    }
+    citation_edges.reserve(previous.numEdges());
+    for (uint32_t pv = 0; pv < previous.numNodes(); ++pv) {
+        for (uint32_t pu : previous.outEdges(pv)) {
+            citation_edges.push_back(packEdge(to_current[pv], to_current[pu]));
+        }
+    }
+    cout << "Delta ingest from " << snapshotPath << ": " << previous.numEdges() << " citations, " << papers_added
+         << " papers not in the CSV" << endl;
+    return true;
+}
 
-        if (diff < CONVERGENCE_THRESHOLD) {
-            ranks = newRanks;
-            break;
+// Warm start for an incremental run: every paper already in the previous snapshot starts from
+// its previous rank, new papers from the smallest of those. The previous graph is only used to
+// count the citations that were added or dropped.
+bool load_previous_ranks(const string& snapshotPath, const Graph& g, vector<double>& ranks, IncrementalStats& stats) {
+    GraphSnapshot previous;
+    try {
+        previous = GraphSnapshot::open(snapshotPath);
+    } catch (const runtime_error& e) {
+        cerr << "Incremental PageRank: cannot use " << snapshotPath << " (" << e.what() << "), starting from scratch" << endl;
+        return false;
+    }
+    stats.previous_nodes = previous.numNodes();
+    stats.previous_edges = previous.numEdges();
+
+    const uint32_t kUnmatched = PaperIdDictionary::kInvalid;
+    vector<uint32_t> to_current(previous.numNodes(), kUnmatched);
+    ranks.assign(g.numNodes(), -1.0);
+    double min_rank = 1.0;
+    for (uint32_t pv = 0; pv < previous.numNodes(); ++pv) {
+        string id = previous.paperId(pv);
+        uint32_t v = id.empty() ? kUnmatched : paper_ids.find(id);
+        if (v == kUnmatched || v >= g.numNodes() || ranks[v] >= 0) continue;
+        to_current[pv] = v;
+        ranks[v] = previous.pageRank(pv);
+        min_rank = min(min_rank, ranks[v]);
+        ++stats.carried_over;
+    }
+    if (stats.carried_over == 0) {
+        cerr << "Incremental PageRank: no paper of " << snapshotPath << " is in the new graph, starting from scratch" << endl;
+        return false;
+    }
+    // The snapshot holds ranks scaled to max 1; the solvers start from a vector summing to 1
+    double sum = 0.0;
+    for (double& r : ranks) {
+        if (r < 0) {
+            r = min_rank;
+            ++stats.new_papers;
+        }
+        sum += r;
+    }
+    for (double& r : ranks) r /= sum;
+
+    // Rows of g are sorted by target, so each previous row is mapped, sorted and merged against it
+    vector<uint32_t> previous_row;
+    uint64_t kept = 0;
+    for (uint32_t pv = 0; pv < previous.numNodes(); ++pv) {
+        if (to_current[pv] == kUnmatched) continue;
+        previous_row.clear();
+        for (uint32_t pu : previous.outEdges(pv)) {
+            if (to_current[pu] != kUnmatched) previous_row.push_back(to_current[pu]);
+        }
+        sort(previous_row.begin(), previous_row.end());
+        ArrayView<uint32_t> row = g.view().neighborsOf(to_current[pv]);
+        size_t i = 0;
+        for (uint32_t u : previous_row) {
+            while (i < row.size() && row[i] < u) ++i;
+            if (i < row.size() && row[i] == u) ++kept;
         }
-        ranks = newRanks;
     }
+    stats.new_citations = g.numEdges() - kept;
+    stats.dropped_citations = stats.previous_edges - kept;
+    return true;
+}
 
-    // Store results (matching original)
-    double maxRank = ranks.maxCoeff();
-    double scaleFactor = 1.0 / maxRank;
+// Citation-biased PageRank: ranks start proportional to log(citationCount), papers citing
+// nothing add a small constant mass, and the result is scaled so the top paper has rank 1.
+void calculate_pagerank(const Graph& g, vector<double>& pageRanks, const BuildOptions& build_options) {
+    PageRankOptions options;
+    options.damping = DAMPING_FACTOR;
+    options.maxIterations = MAX_ITERATIONS;
+    options.tolerance = CONVERGENCE_THRESHOLD;
+    options.danglingMass = MIN_DANGLING_CONTRIBUTION * countZeroDegree(g.view());
+    options.precision = build_options.float_pagerank ? PageRankPrecision::Float : PageRankPrecision::Double;
+    options.simd = build_options.simd;
+    options.solver = build_options.solver;
+    options.onIteration = [](int iteration, double diff) {
+        cout << "Iteration " << iteration << ": diff = " << diff << endl;
+    };
+
+    vector<double> initialRanks = citationBiasedRanks(paper_columns.citationCount);
+    pageRanks = initialRanks;
+    IncrementalStats incremental;
+    bool warm_start = !build_options.previous_snapshot.empty() &&
+                      load_previous_ranks(build_options.previous_snapshot, g, pageRanks, incremental);
+    if (warm_start) {
+        cout << "Incremental PageRank from " << build_options.previous_snapshot << ": " << incremental.carried_over
+             << " of " << incremental.previous_nodes << " papers carried over, " << incremental.new_papers
+             << " new papers, " << incremental.new_citations << " new citations, " << incremental.dropped_citations
+             << " dropped" << endl;
+    }
+    PageRankEngine engine(g.view(), build_options.threads);
+    PageRankResult result = engine.run(pageRanks, options);
+    if (build_options.float_pagerank) {
+        cout << "Float PageRank kernel: " << simdLevelName(result.kernel) << endl;
+    }
+    if (options.solver != PageRankSolver::Power) {
+        cout << "PageRank solver " << pageRankSolverName(options.solver) << ": " << result.iterations << " iterations, "
+             << result.edgesTouched << " edge traversals" << endl;
+    }
 
-    for (tie(vi, vi_end) = vertices(g); vi != vi_end; ++vi) {
-        string originalId = to_string(*vi);
-        int mappedId = idMapping[*vi];
-        pageRanks[originalId] = ranks(mappedId) * scaleFactor;
+    pair<double, double> bounds = scaleToUnitMax(pageRanks);
+    cout << "Min PageRank: " << bounds.first << ", Max PageRank: " << bounds.second << endl;
+
+    if (build_options.pagerank_report) {
+        // The baseline is the double power solve from scratch; the default run is checked against float32 instead
+        bool baseline_run = !build_options.float_pagerank && options.solver == PageRankSolver::Power && !warm_start;
+        string label = baseline_run || build_options.float_pagerank ? "float32" : pageRankSolverName(options.solver);
+        if (warm_start) label = "incremental " + label;
+        vector<double> otherRanks = initialRanks;
+        options.precision = baseline_run ? PageRankPrecision::Float : PageRankPrecision::Double;
+        options.solver = PageRankSolver::Power;
+        options.onIteration = nullptr;
+        PageRankResult other = engine.run(otherRanks, options);
+        scaleToUnitMax(otherRanks);
+        const vector<double>& baselineRanks = baseline_run ? pageRanks : otherRanks;
+        const vector<double>& candidateRanks = baseline_run ? otherRanks : pageRanks;
+        const PageRankResult& baseline = baseline_run ? result : other;
+        const PageRankResult& candidate = baseline_run ? other : result;
+        RankingDrift drift = compareRankings(baselineRanks, candidateRanks, {10, 100, 1000});
+        cout << "PageRank " << label << " vs double power: iterations " << candidate.iterations << " vs "
+             << baseline.iterations << ", edge traversals " << candidate.edgesTouched << " vs " << baseline.edgesTouched
+             << ", L1 " << drift.l1 << " (relative " << drift.l1 / drift.baselineL1 << "), max abs " << drift.maxAbs << endl;
+        for (const auto& overlap : drift.topKOverlap) {
+            cout << "  top-" << overlap.first << " overlap: " << overlap.second * 100 << "%" << endl;
+        }
     }
+}
 
-    double minRank = ranks.minCoeff() * scaleFactor;
-    maxRank = ranks.maxCoeff() * scaleFactor;
-    cout << "Min PageRank: " << minRank << ", Max PageRank: " << maxRank << endl;
+// The --ranking variants share the citation matrix and the dangling mass of the main PageRank,
+// so one batched SpMM per iteration advances all of them. Each column is scaled to max 1.
+RankingColumns calculate_ranking_variants(const Graph& g, const BuildOptions& build_options) {
+    RankingColumns columns;
+    if (build_options.rankings.empty()) return columns;
+    PageRankOptions options;
+    options.maxIterations = MAX_ITERATIONS;
+    options.tolerance = CONVERGENCE_THRESHOLD;
+    options.danglingMass = MIN_DANGLING_CONTRIBUTION * countZeroDegree(g.view());
+
+    vector<BatchColumn> batch;
+    for (const RankingVariant& variant : build_options.rankings) {
+        columns.names.push_back(variant.name);
+        batch.push_back(makeBatchColumn(variant, paper_columns.citationCount, paper_columns.year));
+    }
+    PageRankBatchEngine engine(g.view(), build_options.threads);
+    vector<PageRankResult> results;
+    columns.values = engine.run(batch, options, results);
+    for (size_t j = 0; j < batch.size(); ++j) {
+        scaleToUnitMax(columns.values[j]);
+        cout << "Ranking " << columns.names[j] << ": " << (results[j].converged ? "converged" : "stopped") << " after "
+             << results[j].iterations << " iterations, diff = " << results[j].diff << endl;
+    }
+    cout << "Ranking variants: " << batch.size() << " solved together, "
+         << (results.empty() ? 0 : results[0].edgesTouched) << " edge traversals" << endl;
+    return columns;
 }
 
-void updateDotFile(const Graph& g, const std::unordered_map<string, double>& pageRanks, const string& outputPath) {
+void updateDotFile(const Graph& g, const vector<double>& pageRanks, const string& outputPath) {
     ofstream outfile(outputPath);
     if (!outfile.is_open()) {
         cerr << "Failed to open output file: " << outputPath << endl;
@@ -376,35 +582,105 @@ void updateDotFile(const Graph& g, const std::unordered_map<string, double>& pag
     // outfile << "  rankdir=LR;" << endl;
 
     // Write nodes with properties
-    graph_traits<Graph>::vertex_iterator vi, vi_end;
-    for (tie(vi, vi_end) = vertices(g); vi != vi_end; ++vi) {
-        string id = to_string(*vi);
-        outfile << id << "[label=\"" << g[*vi].name << "\"";
-        outfile << ", year=\"" << g[*vi].year << "\"";
-        outfile << ", citationCount=\"" << g[*vi].centrality << "\"";
-        outfile << ", url=\"" << g[*vi].url << "\"";
-        outfile << ", id=\"" << g[*vi].id << "\"";
-        outfile << ", abstract=\"" << escape_dot_string(g[*vi].abstract) << "\"";
+    for (Vertex v = 0; v < g.numNodes(); ++v) {
+        string id = to_string(v);
+        outfile << id << "[label=\"" << paper_metadata.title(v) << "\"";
+        outfile << ", year=\"" << paper_columns.year[v] << "\"";
+        outfile << ", citationCount=\"" << paper_columns.citationCount[v] << "\"";
+        outfile << ", url=\"" << paper_url(v) << "\"";
+        outfile << ", id=\"" << paper_ids.id(v) << "\"";
+        outfile << ", abstract=\"" << escape_dot_string(string(paper_metadata.abstract(v))) << "\"";
         
         // Add PageRank value if available
-        auto pageRankIt = pageRanks.find(id);
-        if (pageRankIt != pageRanks.end()) {
-            outfile << ", pageRank=\"" << pageRankIt->second << "\"";
+        if (v < pageRanks.size()) {
+            outfile << ", pageRank=\"" << pageRanks[v] << "\"";
         }
         outfile << "];" << endl;
     }
 
     // Write edges
-    graph_traits<Graph>::edge_iterator ei, ei_end;
-    for (tie(ei, ei_end) = edges(g); ei != ei_end; ++ei) {
-        outfile << source(*ei, g) << " -> " << target(*ei, g) << ";" << endl;
+    for (Vertex v = 0; v < g.numNodes(); ++v) {
+        for (Vertex cited : g.view().neighborsOf(v)) {
+            outfile << v << " -> " << cited << ";" << endl;
+        }
     }
 
     outfile << "}" << endl;
     outfile.close();
 }
 
-void store_all_data(const Graph& g, sqlite3* db, const std::unordered_map<string, double>& pageRanks) {
+// Relabels the vertices so papers read together get nearby ids, for every later output (DOT, CSV, SQLite, snapshot)
+void reorder_vertices(Graph& g, VertexOrder order) {
+    CsrGraph in = transposeCsr(g.view());
+    double gap_before = meanLogEdgeGap(g.view());
+    vector<uint32_t> new_to_old = computeVertexOrder(order, g.view(), in.view());
+    vector<uint32_t> old_to_new = invertPermutation(new_to_old);
+    g = permuteCsr(g.view(), new_to_old, old_to_new);
+
+    paper_columns.year = permuteValues(paper_columns.year, new_to_old);
+    paper_columns.citationCount = permuteValues(paper_columns.citationCount, new_to_old);
+    paper_columns.pageRank = permuteValues(paper_columns.pageRank, new_to_old);
+
+    PaperIdDictionary ids;
+    ids.reserve(new_to_old.size());
+    PaperMetadataStore metadata;
+    for (Vertex old : new_to_old) {
+        Vertex v = ids.intern(paper_ids.id(old));
+        if (old < paper_metadata.size()) {
+            metadata.set(v, paper_metadata.title(old), paper_metadata.url(old), paper_metadata.abstract(old));
+        }
+    }
+    paper_ids = std::move(ids);
+    paper_metadata = std::move(metadata);
+    original_vertex = std::move(new_to_old);
+    cout << "Vertices reordered (" << vertexOrderName(order) << "): mean log2 edge gap " << gap_before << " -> "
+         << meanLogEdgeGap(g.view()) << endl;
+}
+
+// Binary snapshot of the graph and its vertex attributes, memory-mapped by the query tools
+void write_graph_snapshot(const Graph& g, const vector<double>& pageRanks, const BuildOptions& options,
+                          const string& outputPath) {
+    uint32_t numNodes = g.numNodes();
+    CsrGraph in = transposeCsr(g.view());
+
+    GraphSnapshotWriter writer(numNodes, g.numEdges());
+    writer.add(SectionKind::OutOffsets, g.offsets);
+    writer.add(SectionKind::OutTargets, g.neighbors);
+    writer.add(SectionKind::InOffsets, in.offsets);
+    writer.add(SectionKind::InSources, in.neighbors);
+    writer.add(SectionKind::Year, paper_columns.year);
+    writer.add(SectionKind::CitationCount, paper_columns.citationCount);
+    writer.add(SectionKind::PageRank, pageRanks);
+    addPaperIdSections(writer, numNodes, paper_ids.packedData(), paper_ids.otherIds());
+    addPaperTextSections(writer, paper_metadata);
+    if (!original_vertex.empty()) writer.add(SectionKind::OriginalVertex, original_vertex);
+    // Lets path queries answer "no path" without a search and skip papers that cannot be on one
+    ReachabilityIndexStats reachability = addReachabilitySections(writer, g.view());
+    cout << "Reachability index: " << reachability.numComponents << " components, " << reachability.dagEdges
+         << " DAG edges, " << reachability.traversals << " GRAIL labels, " << reachability.bytes / 1024 << " KiB, built in "
+         << reachability.buildMs << " ms" << endl;
+    if (options.landmarks > 0) {
+        LandmarkIndexStats landmarks = addLandmarkSections(writer, g.view(), in.view(), pageRanks, options.landmarks,
+                                                           options.landmark_selection);
+        cout << "Landmark distances: " << landmarks.landmarks << " landmarks by "
+             << landmarkSelectionName(options.landmark_selection) << ", " << landmarks.bytes / 1024 << " KiB, built in "
+             << landmarks.buildMs << " ms" << endl;
+    }
+    if (options.ranked_adjacency) {
+        // Top-k children in tree queries become a prefix of the row instead of a sort of it
+        auto start = chrono::steady_clock::now();
+        addRankedAdjacencySections(writer, g.view(), in.view(), paper_columns.year, paper_columns.citationCount, pageRanks);
+        cout << "Ranked adjacency: 5 orders, " << 5 * g.numEdges() * sizeof(uint32_t) / 1024 << " KiB, built in "
+             << chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() << " ms" << endl;
+    }
+    try {
+        writer.writeFile(outputPath);
+    } catch (const std::runtime_error& e) {
+        cerr << e.what() << endl;
+    }
+}
+
+void store_all_data(const Graph& g, sqlite3* db, const vector<double>& pageRanks, const RankingColumns& rankings) {
     // Create tables
     const char* create_tables_sql = R"(
         CREATE TABLE IF NOT EXISTS Nodes (
@@ -430,6 +706,28 @@ void store_all_data(const Graph& g, sqlite3* db, const std::unordered_map<string
         return;
     }
 
+    // --ranking variants are extra REAL columns, added to a Nodes table from an earlier run
+    vector<string> existing_columns;
+    sqlite3_stmt* info_stmt;
+    sqlite3_prepare_v2(db, "PRAGMA table_info(Nodes);", -1, &info_stmt, 0);
+    while (sqlite3_step(info_stmt) == SQLITE_ROW) {
+        existing_columns.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(info_stmt, 1)));
+    }
+    sqlite3_finalize(info_stmt);
+    string ranking_columns_sql;
+    string ranking_values_sql;
+    for (const string& name : rankings.names) {
+        ranking_columns_sql += ", " + name;
+        ranking_values_sql += ", ?";
+        if (find(existing_columns.begin(), existing_columns.end(), name) != existing_columns.end()) continue;
+        string alter_sql = "ALTER TABLE Nodes ADD COLUMN " + name + " REAL;";
+        if (sqlite3_exec(db, alter_sql.c_str(), 0, 0, &err_msg) != SQLITE_OK) {
+            cerr << "SQL error: " << err_msg << endl;
+            sqlite3_free(err_msg);
+            return;
+        }
+    }
+
     cout << "Starting table creation " << endl;
 
     // Begin transaction
@@ -438,25 +736,29 @@ void store_all_data(const Graph& g, sqlite3* db, const std::unordered_map<string
     cout << "Starting inserting into Nodes " << endl;
     // Store nodes with PageRank and abstract
     sqlite3_stmt* node_stmt;
-    const char* insert_node_sql = 
-        "INSERT OR REPLACE INTO Nodes (id, label, year, citationCount, url, pageRank, abstract) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?);";
-    sqlite3_prepare_v2(db, insert_node_sql, -1, &node_stmt, 0);
-
-    graph_traits<Graph>::vertex_iterator vi, vi_end;
-    for (tie(vi, vi_end) = vertices(g); vi != vi_end; ++vi) {
-        string id = g[*vi].id;
+    string insert_node_sql =
+        "INSERT OR REPLACE INTO Nodes (id, label, year, citationCount, url, pageRank, abstract" + ranking_columns_sql + ") "
+        "VALUES (?, ?, ?, ?, ?, ?, ?" + ranking_values_sql + ");";
+    sqlite3_prepare_v2(db, insert_node_sql.c_str(), -1, &node_stmt, 0);
+
+    for (Vertex v = 0; v < g.numNodes(); ++v) {
+        string id = paper_ids.id(v);
         sqlite3_bind_text(node_stmt, 1, id.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(node_stmt, 2, g[*vi].name.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_int(node_stmt, 3, g[*vi].year);
-        sqlite3_bind_int(node_stmt, 4, g[*vi].centrality);
-        sqlite3_bind_text(node_stmt, 5, g[*vi].url.c_str(), -1, SQLITE_STATIC);
+        string_view label = paper_metadata.title(v);
+        string url = paper_url(v);
+        sqlite3_bind_text(node_stmt, 2, label.data(), static_cast<int>(label.size()), SQLITE_STATIC);
+        sqlite3_bind_int(node_stmt, 3, paper_columns.year[v]);
+        sqlite3_bind_int(node_stmt, 4, paper_columns.citationCount[v]);
+        sqlite3_bind_text(node_stmt, 5, url.c_str(), -1, SQLITE_STATIC);
         
-        auto pageRankIt = pageRanks.find(to_string(*vi));
-        double pageRankValue = pageRankIt != pageRanks.end() ? pageRankIt->second : 0.0;
+        double pageRankValue = v < pageRanks.size() ? pageRanks[v] : 0.0;
         sqlite3_bind_double(node_stmt, 6, pageRankValue);
 
-        sqlite3_bind_text(node_stmt, 7, g[*vi].abstract.c_str(), -1, SQLITE_STATIC);
+        string_view abstract = paper_metadata.abstract(v);
+        sqlite3_bind_text(node_stmt, 7, abstract.data(), static_cast<int>(abstract.size()), SQLITE_STATIC);
+        for (size_t j = 0; j < rankings.values.size(); ++j) {
+            sqlite3_bind_double(node_stmt, static_cast<int>(8 + j), rankings.values[j][v]);
+        }
         
         sqlite3_step(node_stmt);
         sqlite3_reset(node_stmt);
@@ -470,16 +772,17 @@ void store_all_data(const Graph& g, sqlite3* db, const std::unordered_map<string
         "INSERT OR IGNORE INTO PaperEdges (source_id, target_id) VALUES (?, ?);";
     sqlite3_prepare_v2(db, insert_edge_sql, -1, &edge_stmt, 0);
 
-    graph_traits<Graph>::edge_iterator ei, ei_end;
-    for (tie(ei, ei_end) = edges(g); ei != ei_end; ++ei) {
-        string source_id = g[source(*ei, g)].id;
-        string target_id = g[target(*ei, g)].id;
-        
-        sqlite3_bind_text(edge_stmt, 1, source_id.c_str(), -1, SQLITE_STATIC);
-        sqlite3_bind_text(edge_stmt, 2, target_id.c_str(), -1, SQLITE_STATIC);
-        
-        sqlite3_step(edge_stmt);
-        sqlite3_reset(edge_stmt);
+    for (Vertex v = 0; v < g.numNodes(); ++v) {
+        string source_id = paper_ids.id(v);
+        for (Vertex cited : g.view().neighborsOf(v)) {
+            string target_id = paper_ids.id(cited);
+
+            sqlite3_bind_text(edge_stmt, 1, source_id.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(edge_stmt, 2, target_id.c_str(), -1, SQLITE_STATIC);
+
+            sqlite3_step(edge_stmt);
+            sqlite3_reset(edge_stmt);
+        }
     }
     sqlite3_finalize(edge_stmt);
 
@@ -488,47 +791,138 @@ void store_all_data(const Graph& g, sqlite3* db, const std::unordered_map<string
 }
 
 
-void export_graph_to_csv(const Graph& g, const std::unordered_map<string, double>& pageRanks,
+void export_graph_to_csv(const Graph& g, const vector<double>& pageRanks, const RankingColumns& rankings,
                         const string& nodes_csv_path = "data/citation_nodes.csv",
                         const string& edges_csv_path = "data/citation_edges.csv") {
     // Write Nodes CSV
     ofstream nodes_csv(nodes_csv_path);
-    nodes_csv << "id,label,year,citationCount,url,pageRank,abstract\n";
-    graph_traits<Graph>::vertex_iterator vi, vi_end;
-    for (tie(vi, vi_end) = vertices(g); vi != vi_end; ++vi) {
-        string id = g[*vi].id;
-        string label = g[*vi].name;
-        int year = g[*vi].year;
-        int citationCount = g[*vi].centrality;
-        string url = g[*vi].url;
+    nodes_csv << "id,label,year,citationCount,url,pageRank,abstract";
+    for (const string& name : rankings.names) nodes_csv << "," << name;
+    nodes_csv << "\n";
+    for (Vertex v = 0; v < g.numNodes(); ++v) {
+        string id = paper_ids.id(v);
+        string label(paper_metadata.title(v));
+        int year = paper_columns.year[v];
+        int citationCount = paper_columns.citationCount[v];
+        string url = paper_url(v);
         double pageRankValue = 0.0;
-        auto pageRankIt = pageRanks.find(to_string(*vi));
-        if (pageRankIt != pageRanks.end()) pageRankValue = pageRankIt->second;
-        string abstract_str = g[*vi].abstract;
+        if (v < pageRanks.size()) pageRankValue = pageRanks[v];
+        string abstract_str(paper_metadata.abstract(v));
         // Escape quotes for CSV
         std::replace(label.begin(), label.end(), '"', '\'');
         std::replace(abstract_str.begin(), abstract_str.end(), '"', '\'');
 
         std::replace(label.begin(), label.end(), '\\', '/');
         std::replace(abstract_str.begin(), abstract_str.end(), '\\', '/');
-        nodes_csv << '"' << id << "\",\"" << label << "\"," << year << "," << citationCount << ",\"" << url << "\"," << pageRankValue << ",\"" << abstract_str << "\"\n";
+        nodes_csv << '"' << id << "\",\"" << label << "\"," << year << "," << citationCount << ",\"" << url << "\"," << pageRankValue << ",\"" << abstract_str << '"';
+        for (const vector<double>& values : rankings.values) nodes_csv << "," << values[v];
+        nodes_csv << "\n";
     }
     nodes_csv.close();
 
     // Write Edges CSV
     ofstream edges_csv(edges_csv_path);
     edges_csv << "source_id,target_id\n";
-    graph_traits<Graph>::edge_iterator ei, ei_end;
-    for (tie(ei, ei_end) = edges(g); ei != ei_end; ++ei) {
-        string source_id = g[source(*ei, g)].id;
-        string target_id = g[target(*ei, g)].id;
-        edges_csv << '"' << source_id << "\",\"" << target_id << "\"\n";
+    for (Vertex v = 0; v < g.numNodes(); ++v) {
+        string source_id = paper_ids.id(v);
+        for (Vertex cited : g.view().neighborsOf(v)) {
+            edges_csv << '"' << source_id << "\",\"" << paper_ids.id(cited) << "\"\n";
+        }
     }
     edges_csv.close();
 }
 
-int main() {
-    // g++ -std=c++11 -I$BOOST_INCLUDE_PATH -I$RAPIDJSON_INCLUDE_PATH -L$BOOST_LIB_PATH -lboost_graph -lboost_system -I /Users/akashkumar/Downloads/eigen-3.4.0  -lsqlite3 -o build_graph/citation_network build_graph/main.cpp
+BuildOptions parse_build_options(int argc, char* argv[]) {
+    BuildOptions options;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--parallel-jsonl") {
+            options.parallel_jsonl = true;
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            options.threads = max(1, stoi(arg.substr(10)));
+        } else if (arg == "--float-pagerank") {
+            options.float_pagerank = true;
+        } else if (arg == "--pagerank-report") {
+            options.pagerank_report = true;
+        } else if (arg == "--simd=scalar") {
+            options.simd = SimdLevel::Scalar;
+        } else if (arg == "--simd=avx2") {
+            options.simd = SimdLevel::Avx2;
+        } else if (arg == "--simd=avx512") {
+            options.simd = SimdLevel::Avx512;
+        } else if (arg == "--pagerank-solver=power") {
+            options.solver = PageRankSolver::Power;
+        } else if (arg == "--pagerank-solver=gauss-seidel") {
+            options.solver = PageRankSolver::GaussSeidel;
+        } else if (arg == "--pagerank-solver=push") {
+            options.solver = PageRankSolver::Push;
+        } else if (arg == "--incremental") {
+            options.previous_snapshot = "data/citation_network.snapshot";
+        } else if (arg.rfind("--incremental=", 0) == 0) {
+            options.previous_snapshot = arg.substr(14);
+        } else if (arg.rfind("--delta-references=", 0) == 0) {
+            options.delta_references = arg.substr(19);
+        } else if (arg.rfind("--reorder=", 0) == 0) {
+            if (!parseVertexOrder(arg.substr(10), options.vertex_order)) {
+                cerr << "Unknown vertex order: " << arg.substr(10) << " (degree, rcm, gorder or original)" << endl;
+                exit(EXIT_FAILURE);
+            }
+        } else if (arg == "--no-ranked-adjacency") {
+            options.ranked_adjacency = false;
+        } else if (arg.rfind("--landmarks=", 0) == 0) {
+            string value = arg.substr(12);
+            size_t colon = value.find(':');
+            options.landmarks = static_cast<unsigned>(max(0, stoi(value.substr(0, colon))));
+            if (colon != string::npos && !parseLandmarkSelection(value.substr(colon + 1), options.landmark_selection)) {
+                cerr << "Unknown landmark selection: " << value.substr(colon + 1) << " (pagerank or degree)" << endl;
+                exit(EXIT_FAILURE);
+            }
+        } else if (arg.rfind("--ranking=", 0) == 0) {
+            try {
+                options.rankings.push_back(parseRankingVariant(arg.substr(10)));
+            } catch (const runtime_error& e) {
+                cerr << e.what() << endl;
+                exit(EXIT_FAILURE);
+            }
+        } else {
+            cerr << "Unknown option: " << arg << endl;
+            cerr << "Usage: " << argv[0] << " [--parallel-jsonl] [--threads=N] [--float-pagerank] [--pagerank-report]"
+             << " [--simd=scalar|avx2|avx512] [--pagerank-solver=power|gauss-seidel|push]"
+             << " [--incremental[=previous snapshot] [--delta-references=new references.jsonl]]"
+             << " [--reorder=degree|rcm|gorder] [--landmarks=N[:pagerank|degree]] [--no-ranked-adjacency]"
+             << " [--ranking=name[:damping=D,start=uniform|citations,teleport=uniform|year,decay=YEARS]]..." << endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (!options.delta_references.empty() && options.previous_snapshot.empty()) {
+        cerr << "--delta-references needs --incremental, whose snapshot holds the earlier citations" << endl;
+        exit(EXIT_FAILURE);
+    }
+    if (options.float_pagerank && options.solver != PageRankSolver::Power) {
+        cerr << "--float-pagerank only applies to --pagerank-solver=power" << endl;
+        exit(EXIT_FAILURE);
+    }
+    // Ranking names become Nodes columns; SQLite compares column names case-insensitively
+    vector<string> column_names = {"id", "label", "year", "citationcount", "url", "pagerank", "abstract"};
+    for (const RankingVariant& variant : options.rankings) {
+        string lower = variant.name;
+        transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return tolower(c); });
+        if (find(column_names.begin(), column_names.end(), lower) != column_names.end()) {
+            cerr << "Ranking name " << variant.name << " is already a Nodes column" << endl;
+            exit(EXIT_FAILURE);
+        }
+        column_names.push_back(lower);
+    }
+    if (options.rankings.size() > PageRankBatchEngine::kMaxColumns) {
+        cerr << "At most " << PageRankBatchEngine::kMaxColumns << " --ranking variants" << endl;
+        exit(EXIT_FAILURE);
+    }
+    return options;
+}
+
+int main(int argc, char* argv[]) {
+    // g++ -std=c++17 -O2 -pthread -I$BOOST_INCLUDE_PATH -I$RAPIDJSON_INCLUDE_PATH -L$BOOST_LIB_PATH -lboost_graph -lboost_system -lsqlite3 -o build_graph/citation_network build_graph/main.cpp
+    BuildOptions options = parse_build_options(argc, argv);
     auto start_time = chrono::high_resolution_clock::now();
 
     // Load paper information from cleaned CSV file
@@ -537,27 +931,47 @@ int main() {
 
     cout << "CSV lines processed: " << csv_lines_processed << ", CSV lines skipped: " << csv_lines_skipped << endl;
 
-    // Parse the JSONL file to build the graph
+    // Parse the JSONL file to build the graph, or only the new references on top of the previous snapshot
     string jsonl_filename = "data/references_complete_pruned.jsonl";
-    parse_jsonl_file(jsonl_filename);
+    if (!options.delta_references.empty() && load_previous_citations(options.previous_snapshot)) {
+        jsonl_filename = options.delta_references;
+    }
+    if (options.parallel_jsonl) {
+        parse_jsonl_file_parallel(jsonl_filename, options.threads);
+    } else {
+        parse_jsonl_file(jsonl_filename);
+    }
 
     cout << "JSON lines processed: " << json_lines_processed << ", JSON lines skipped: " << json_lines_skipped << endl;
     cout << "Citing nodes created (not present in initial graph): " << citing_nodes_created << endl;
 
-    // Save the graph to a file with custom property writer
-    ofstream dotfile("data/citation_network.dot");
-    write_graphviz(dotfile, g, VertexPropertyWriter(g));
+    // Sort and deduplicate the collected citations straight into CSR
+    EdgeDedupStats edge_stats;
+    g = buildCsrFromEdgeKeys(paper_ids.size(), citation_edges, options.threads, &edge_stats);
+    vector<uint64_t>().swap(citation_edges);
+    cout << "Citation edges: " << edge_stats.inputEdges << " read, " << edge_stats.uniqueEdges << " unique, "
+         << edge_stats.duplicateEdges << " duplicates dropped (" << edge_stats.repeatedPairs
+         << " pairs repeated, max multiplicity " << edge_stats.maxMultiplicity << "), "
+         << edge_stats.selfLoops << " self-citations" << endl;
+    if (options.vertex_order != VertexOrder::Original) reorder_vertices(g, options.vertex_order);
 
-    cout << "Graph construction complete. Nodes: " << num_vertices(g) << ", Edges: " << num_edges(g) << endl;
+    // Save the graph as DOT
+    write_dot_file(g, "data/citation_network.dot");
+
+    cout << "Graph construction complete. Nodes: " << g.numNodes() << ", Edges: " << g.numEdges() << endl;
+    cout << "Paper id dictionary: " << paper_ids.size() << " ids, " << paper_ids.memoryBytes() / (1024.0 * 1024.0) << " MB" << endl;
+    cout << "Vertex columns: " << paper_columns.memoryBytes() / (1024.0 * 1024.0) << " MB, metadata store: "
+         << paper_metadata.memoryBytes() / (1024.0 * 1024.0) << " MB" << endl;
 
     auto mid_time = chrono::high_resolution_clock::now();
     chrono::duration<double> graph_build_duration = mid_time - start_time;
     cout << "Total time for graph creation " << graph_build_duration.count() << " seconds" << endl;
 
     // Calculate PageRank
-    std::unordered_map<string, double> pageRanks;
+    vector<double>& pageRanks = paper_columns.pageRank;
     cout << "Starting PageRank calculation..." << endl;
-    calculate_pagerank(g, pageRanks);
+    calculate_pagerank(g, pageRanks, options);
+    RankingColumns rankings = calculate_ranking_variants(g, options);
     cout << "PageRank calculation complete" << endl;
 
     auto mid_time_1 = chrono::high_resolution_clock::now();
@@ -573,10 +987,17 @@ int main() {
     chrono::duration<double> dot_file_duration = mid_time_2 - mid_time_1;
     cout << "Total time for saving new dot file " << dot_file_duration.count() << " seconds" << endl;
 
+    cout << "Writing graph snapshot..." << endl;
+    write_graph_snapshot(g, pageRanks, options, "data/citation_network.snapshot");
+    auto snapshot_time = chrono::high_resolution_clock::now();
+    chrono::duration<double> snapshot_duration = snapshot_time - mid_time_2;
+    cout << "Total time for saving graph snapshot " << snapshot_duration.count() << " seconds" << endl;
+    mid_time_2 = snapshot_time;
+
     // Store everything in database
     sqlite3* db;
     if (sqlite3_open("data/citations_data.db", &db) == SQLITE_OK) {
-        store_all_data(g, db, pageRanks);
+        store_all_data(g, db, pageRanks, rankings);
         sqlite3_close(db);
         cout << "Database population complete" << endl;
     } else {
@@ -588,7 +1009,7 @@ int main() {
     chrono::duration<double> db_duration = mid_time_3 - mid_time_2;
     cout << "Total time for creating and saving info in database " << db_duration.count() << " seconds" << endl;
 
-    export_graph_to_csv(g, pageRanks, "data/citation_nodes.csv", "data/citation_edges.csv");
+    export_graph_to_csv(g, pageRanks, rankings, "data/citation_nodes.csv", "data/citation_edges.csv");
 
     auto mid_time_4 = chrono::high_resolution_clock::now();
     chrono::duration<double> csv_file_duration = mid_time_4 - mid_time_3;
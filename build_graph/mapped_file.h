@@ -0,0 +1,143 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Read-only or copy-on-write memory mapping of a whole file.
+// CopyOnWrite mappings can be modified in place (e.g. for in-situ parsing)
+// without touching the file on disk.
+class MappedFile {
+public:
+    enum Mode { ReadOnly, CopyOnWrite };
+
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& filename, Mode mode = ReadOnly) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Error opening file: " + filename + " (" + std::strerror(errno) + ")");
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Error reading file size: " + filename);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            int prot = mode == ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+            void* addr = ::mmap(nullptr, size_, prot, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Error mapping file: " + filename + " (" + std::strerror(errno) + ")");
+            }
+            data_ = static_cast<char*>(addr);
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() { reset(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            reset();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+
+    char* data() { return data_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void adviseSequential() const { advise(MADV_SEQUENTIAL); }
+    void adviseRandom() const { advise(MADV_RANDOM); }
+    void adviseWillNeed() const { advise(MADV_WILLNEED); }
+
+private:
+    void advise(int advice) const {
+        if (data_) ::madvise(data_, size_, advice);
+    }
+
+    void reset() {
+        if (data_) ::munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Writes a file that readers map: fill(write) produces the contents through write(data, bytes)
+// into filename + ".tmp", which is synced and renamed over filename, so readers see the old file
+// or all of the new one, also after a crash. The temporary file is removed when anything fails;
+// what names the file in errors.
+template <typename FillFn>
+void replaceFile(const std::string& filename, const std::string& what, FillFn fill) {
+    std::string tmp = filename + ".tmp";
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("Failed to open " + what + ": " + tmp + " (" + std::strerror(errno) + ")");
+    bool ok = true;
+    auto write = [&](const char* data, size_t bytes) {
+        while (ok && bytes > 0) {
+            ssize_t n = ::write(fd, data, bytes);
+            if (n < 0 && errno == EINTR) continue;
+            ok = n > 0;
+            if (ok) {
+                data += n;
+                bytes -= static_cast<size_t>(n);
+            }
+        }
+    };
+    try {
+        fill(write);
+    } catch (...) {
+        ::close(fd);
+        std::remove(tmp.c_str());
+        throw;
+    }
+    ok = ::fsync(fd) == 0 && ok;
+    ok = ::close(fd) == 0 && ok;
+    if (!ok || std::rename(tmp.c_str(), filename.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("Failed to write " + what + ": " + filename);
+    }
+}
+
+// Splits [0, size) into at most numChunks ranges whose boundaries fall just
+// after a '\n', so that every line belongs to exactly one chunk.
+inline std::vector<std::pair<size_t, size_t>> splitAtNewlines(const char* data, size_t size, size_t numChunks) {
+    std::vector<std::pair<size_t, size_t>> chunks;
+    if (size == 0 || numChunks == 0) return chunks;
+
+    size_t begin = 0;
+    for (size_t i = 1; i <= numChunks && begin < size; ++i) {
+        size_t end = i == numChunks ? size : std::max(begin, size / numChunks * i);
+        if (end < size) {
+            const void* nl = std::memchr(data + end, '\n', size - end);
+            end = nl ? static_cast<const char*>(nl) - data + 1 : size;
+        }
+        if (end > begin) chunks.emplace_back(begin, end);
+        begin = end;
+    }
+    return chunks;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "csr_graph.h"
+
+// Multi-source BFS (Then et al., "The More the Merrier"): up to 64 * Words traversals at once.
+// Every vertex carries one bit per source for seen, frontier and next, so a vertex on the
+// frontier of many sources has its row scanned once per level for all of them, and the batch
+// costs about one BFS over the union of the traversals rather than one per root.
+//
+// It finds levels (hop distances), not BFS trees: a tree needs each vertex's first parent in
+// its own source's BFS order, which is per-source work again, so trees stay with BfsTreeBuilder.
+// Sources have their own depth (< 0: no limit); roots may repeat. Over two CSRs (a graph and its
+// transpose) the traversal ignores direction.
+
+template <size_t Words>
+class MultiSourceBfs {
+public:
+    static constexpr size_t kBatch = 64 * Words;
+    using Bits = std::array<uint64_t, Words>;
+
+    explicit MultiSourceBfs(const CsrView& graph) : MultiSourceBfs(graph, CsrView()) {}
+    MultiSourceBfs(const CsrView& graph, const CsrView& reverse)
+        : graph_(graph), reverse_(reverse), seen_(graph.numNodes), visit_(graph.numNodes), next_(graph.numNodes) {}
+
+    // Runs the batch, calling level(level, vertices) with the vertices first reached on each level
+    // by some source; reachedBits(vertex) are the sources. False when the deadline cut it short.
+    template <typename LevelFn>
+    bool run(const std::vector<uint32_t>& roots, const std::vector<int>& depths, LevelFn level,
+             std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+        if (roots.size() > kBatch || depths.size() != roots.size()) throw std::runtime_error("Bad multi-source BFS batch");
+        frontier_.clear();
+        for (size_t s = 0; s < roots.size(); ++s) {
+            if (isEmpty(seen_[roots[s]])) frontier_.push_back(roots[s]);
+            set(seen_[roots[s]], s);
+            set(visit_[roots[s]], s);
+        }
+        touched_ = frontier_;
+
+        bool complete = true;
+        for (uint32_t depth = 0; !frontier_.empty(); ++depth) {
+            Bits active{};
+            for (size_t s = 0; s < roots.size(); ++s) {
+                if (depths[s] < 0 || depth < static_cast<uint32_t>(depths[s])) set(active, s);
+            }
+            if (isEmpty(active)) break;
+            if (std::chrono::steady_clock::now() >= deadline) {
+                complete = false;
+                break;
+            }
+            reached_.clear();
+            for (uint32_t v : frontier_) {
+                Bits bits = visit_[v];
+                clear(visit_[v]);
+                if (!intersect(bits, active)) continue;
+                auto scan = [&](ArrayView<uint32_t> row) {
+                    for (uint32_t u : row) {
+                        Bits fresh = bits;
+                        if (!subtract(fresh, seen_[u])) continue;
+                        if (isEmpty(next_[u])) reached_.push_back(u);
+                        for (size_t w = 0; w < Words; ++w) next_[u][w] |= fresh[w];
+                    }
+                };
+                scan(graph_.neighborsOf(v));
+                if (reverse_.numNodes) scan(reverse_.neighborsOf(v));
+            }
+            for (uint32_t u : reached_) {
+                for (size_t w = 0; w < Words; ++w) seen_[u][w] |= next_[u][w];
+            }
+            touched_.insert(touched_.end(), reached_.begin(), reached_.end());
+            if (!reached_.empty()) level(depth + 1, reached_);
+            for (uint32_t u : reached_) {
+                visit_[u] = next_[u];
+                clear(next_[u]);
+            }
+            frontier_.swap(reached_);
+        }
+
+        // Only the vertices of this batch were touched
+        for (uint32_t v : touched_) {
+            clear(seen_[v]);
+            clear(visit_[v]);
+        }
+        return complete;
+    }
+
+    // Inside run's level function: the sources that reached v on that level
+    const Bits& reachedBits(uint32_t v) const { return next_[v]; }
+
+    // Papers on each level of the BFS tree of every root with depths[i] levels (sizes[i][0] is
+    // the root), kBatch roots per run; empty when the deadline passed first.
+    std::vector<std::vector<uint32_t>> levelSizes(const std::vector<uint32_t>& roots, const std::vector<int>& depths,
+                                                  std::chrono::steady_clock::time_point deadline =
+                                                      std::chrono::steady_clock::time_point::max()) {
+        std::vector<std::vector<uint32_t>> sizes(roots.size(), std::vector<uint32_t>(1, 1));
+        for (size_t begin = 0; begin < roots.size(); begin += kBatch) {
+            size_t end = std::min(roots.size(), begin + kBatch);
+            auto level = [&](uint32_t depth, const std::vector<uint32_t>& reached) {
+                for (uint32_t u : reached) {
+                    forEachSource(next_[u], [&](size_t s) {
+                        std::vector<uint32_t>& levels = sizes[begin + s];
+                        if (levels.size() <= depth) levels.resize(depth + 1, 0);
+                        ++levels[depth];
+                    });
+                }
+            };
+            if (!run(std::vector<uint32_t>(roots.begin() + begin, roots.begin() + end),
+                     std::vector<int>(depths.begin() + begin, depths.begin() + end), level, deadline)) {
+                return {};
+            }
+        }
+        return sizes;
+    }
+
+    // Calls fn(source) for every bit set in bits
+    template <typename Fn>
+    static void forEachSource(const Bits& bits, Fn fn) {
+        for (size_t w = 0; w < Words; ++w) {
+            for (uint64_t word = bits[w]; word; word &= word - 1) fn(w * 64 + __builtin_ctzll(word));
+        }
+    }
+
+private:
+    static void set(Bits& bits, size_t s) { bits[s / 64] |= uint64_t(1) << (s % 64); }
+    static void clear(Bits& bits) { bits.fill(0); }
+    static bool isEmpty(const Bits& bits) {
+        for (uint64_t word : bits) {
+            if (word) return false;
+        }
+        return true;
+    }
+    // bits &= mask (subtract: bits &= ~mask); true when anything is left
+    static bool intersect(Bits& bits, const Bits& mask) {
+        uint64_t any = 0;
+        for (size_t w = 0; w < Words; ++w) any |= bits[w] &= mask[w];
+        return any != 0;
+    }
+    static bool subtract(Bits& bits, const Bits& mask) {
+        uint64_t any = 0;
+        for (size_t w = 0; w < Words; ++w) any |= bits[w] &= ~mask[w];
+        return any != 0;
+    }
+
+    CsrView graph_;
+    CsrView reverse_;
+    std::vector<Bits> seen_;
+    std::vector<Bits> visit_;
+    std::vector<Bits> next_;
+    std::vector<uint32_t> frontier_;
+    std::vector<uint32_t> reached_;
+    std::vector<uint32_t> touched_;
+};
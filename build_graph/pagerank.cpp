@@ -1,142 +1,39 @@
 #include <iostream>
+#include <iomanip>
 #include <fstream>
 #include <sstream>
 #include <string>
-#include <unordered_map>
 #include <vector>
-#include <cmath>
-#include <limits>
-#include <thread>
-#include <mutex>
+
+#include "dot_graph_loader.h"
+#include "pagerank_engine.h"
 
 const double DAMPING_FACTOR = 0.85;
 const int MAX_ITERATIONS = 100;
 const double CONVERGENCE_THRESHOLD = 1e-6;
-const int NUM_THREADS = 8;  // Adjust this based on your CPU
-
-struct Node {
-    std::string label;
-    int year;
-    int citationCount;
-    double pageRank;
-    std::vector<int> outEdges;
-    std::vector<int> inEdges;
-};
-
-std::mutex mtx;
-
-void parseDotFile(const std::string& filename, std::unordered_map<int, Node>& graph) {
-    std::ifstream infile(filename);
-    std::string line;
-    int lineNumber = 0;
-    try {
-        while (std::getline(infile, line)) {
-            ++lineNumber;
-            if (line.find("->") != std::string::npos) {
-                std::stringstream ss(line);
-                int from, to;
-                char ignore;
-                ss >> from >> ignore >> ignore >> to;
-                graph[from].outEdges.push_back(to);
-                graph[to].inEdges.push_back(from);
-            } else if (line.find("[label=") != std::string::npos) {
-                std::stringstream ss;
-                ss << line;
-                while (line.find("];") == std::string::npos) {
-                    if (!std::getline(infile, line)) {
-                        throw std::runtime_error("Incomplete node definition at end of file.");
-                    }
-                    ss << line;
-                    ++lineNumber;
-                }
-
-                std::string fullLine = ss.str();
-                std::stringstream fullSS(fullLine);
-                int id;
-                fullSS >> id;
-                Node node;
-                size_t labelStart = fullLine.find("label=\"") + 7;
-                size_t labelEnd = fullLine.find("\",", labelStart);
-                node.label = fullLine.substr(labelStart, labelEnd - labelStart);
-
-                size_t yearStart = fullLine.find("year=\"") + 6;
-                size_t yearEnd = fullLine.find("\",", yearStart);
-                node.year = std::stoi(fullLine.substr(yearStart, yearEnd - yearStart));
-
-                size_t citationCountStart = fullLine.find("citationCount=\"") + 15;
-                size_t citationCountEnd = fullLine.find("\"]", citationCountStart);
-                node.citationCount = std::stoi(fullLine.substr(citationCountStart, citationCountEnd - citationCountStart));
-
-                node.pageRank = 1.0;
-                graph[id] = node;
-            }
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing line " << lineNumber << ": " << line << std::endl;
-        std::cerr << "Exception: " << e.what() << std::endl;
-        exit(EXIT_FAILURE);
-    }
-}
-
-void computePageRankChunk(std::unordered_map<int, Node>& graph, std::unordered_map<int, double>& newPageRanks, int start, int end) {
-    double localDiff = 0.0;
-
-    for (auto it = graph.begin(); std::distance(graph.begin(), it) < end; ++it) {
-        if (std::distance(graph.begin(), it) < start) continue;
-
-        int id = it->first;
-        Node& node = it->second;
-        double rankSum = 0.0;
 
-        for (int inEdge : node.inEdges) {
-            rankSum += graph[inEdge].pageRank / graph[inEdge].outEdges.size();
-        }
-
-        double newRank = (1 - DAMPING_FACTOR) / graph.size() + DAMPING_FACTOR * rankSum;
-        newPageRanks[id] = newRank;
-        localDiff += std::abs(newRank - node.pageRank);
+// Textbook PageRank: every paper passes its rank on to the papers it cites, split evenly.
+// Pulls over the in-edges (CSC) on all cores.
+PageRankResult computePageRank(const GraphSnapshot& graph, std::vector<double>& pageRanks) {
+    std::vector<double> shares(graph.numNodes(), 0.0);
+    for (uint32_t v = 0; v < graph.numNodes(); ++v) {
+        if (graph.outDegree(v) > 0) shares[v] = 1.0 / graph.outDegree(v);
     }
 
-    std::lock_guard<std::mutex> lock(mtx);
-    for (auto it = newPageRanks.begin(); std::distance(newPageRanks.begin(), it) < end; ++it) {
-        if (std::distance(newPageRanks.begin(), it) < start) continue;
-
-        graph[it->first].pageRank = it->second;
-    }
+    PageRankOptions options;
+    options.damping = DAMPING_FACTOR;
+    options.maxIterations = MAX_ITERATIONS;
+    options.tolerance = CONVERGENCE_THRESHOLD;
+    options.normalizeSum = false;
+    options.l1Diff = true;
+
+    PageRankEngine engine(graph.in(), defaultThreadCount());
+    engine.setSourceWeights(std::move(shares));
+    pageRanks.assign(graph.numNodes(), 1.0);
+    return engine.run(pageRanks, options);
 }
 
-void computePageRank(std::unordered_map<int, Node>& graph) {
-    int numNodes = graph.size();
-    std::unordered_map<int, double> newPageRanks;
-
-    for (int iteration = 0; iteration < MAX_ITERATIONS; ++iteration) {
-        std::vector<std::thread> threads;
-        int chunkSize = numNodes / NUM_THREADS;
-
-        for (int i = 0; i < NUM_THREADS; ++i) {
-            int start = i * chunkSize;
-            int end = (i + 1) * chunkSize;
-            if (i == NUM_THREADS - 1) end = numNodes;
-
-            threads.emplace_back(computePageRankChunk, std::ref(graph), std::ref(newPageRanks), start, end);
-        }
-
-        for (auto& thread : threads) {
-            thread.join();
-        }
-
-        double diff = 0.0;
-        for (const auto& [id, node] : graph) {
-            diff += std::abs(newPageRanks[id] - node.pageRank);
-        }
-
-        if (diff < CONVERGENCE_THRESHOLD) {
-            break;
-        }
-    }
-}
-
-void updateDotFile(const std::string& filename, std::unordered_map<int, Node>& graph) {
+void updateDotFile(const std::string& filename, const std::vector<double>& pageRanks) {
     std::ifstream infile(filename);
     std::ofstream outfile("output.dot");
     std::string line;
@@ -148,7 +45,8 @@ void updateDotFile(const std::string& filename, std::unordered_map<int, Node>& g
             int id;
             ss >> id;
             size_t pos = line.find("];");
-            std::string newLine = line.substr(0, pos) + ", pageRank=\"" + std::to_string(graph[id].pageRank) + "\"];";
+            double pageRank = id >= 0 && id < static_cast<int>(pageRanks.size()) ? pageRanks[id] : 0.0;
+            std::string newLine = line.substr(0, pos) + ", pageRank=\"" + std::to_string(pageRank) + "\"];";
             outfile << newLine << std::endl;
         } else {
             outfile << line << std::endl;
@@ -156,10 +54,59 @@ void updateDotFile(const std::string& filename, std::unordered_map<int, Node>& g
     }
 }
 
-int main() {
-    std::unordered_map<int, Node> graph;
-    parseDotFile("data/citation_network_fixed.dot", graph);
-    computePageRank(graph);
-    updateDotFile("data/citation_network_fixed.dot", graph);
+// The textbook ranks of a snapshot's papers as vertex,paperId,pageRank lines
+void writeRankCsv(const GraphSnapshot& graph, const std::vector<double>& pageRanks, const std::string& filename) {
+    std::ofstream outfile(filename);
+    if (!outfile.is_open()) throw std::runtime_error("Cannot open " + filename);
+    outfile << "vertex,paperId,pageRank" << std::endl;
+    outfile << std::setprecision(10);
+    for (uint32_t v = 0; v < graph.numNodes(); ++v) outfile << v << "," << graph.paperId(v) << "," << pageRanks[v] << "\n";
+    if (!outfile) throw std::runtime_error("Failed to write " + filename);
+}
+
+int main(int argc, char* argv[]) {
+    // g++ -std=c++17 -O2 -pthread -o pagerank_classic pagerank.cpp
+    // A DOT file gets a copy with the ranks (output.dot). A snapshot is left alone: its ranks are
+    // the scaled production ones the other tools use, so these go to a CSV, or with
+    // --output=<file>.snapshot to a copy of the snapshot with them scaled to max 1.
+    std::string graph_filename = "data/citation_network_fixed.dot";
+    std::string output;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--output=", 0) == 0) {
+            output = arg.substr(9);
+        } else if (arg.rfind("--", 0) != 0) {
+            graph_filename = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [graph file] [--output=data/pagerank_classic.csv|<file>.snapshot]" << std::endl;
+            return 1;
+        }
+    }
+    try {
+        GraphSnapshot graph = openGraph(graph_filename);
+        std::vector<double> pageRanks;
+        PageRankResult result = computePageRank(graph, pageRanks);
+        std::cout << "PageRank " << (result.converged ? "converged" : "stopped") << " after " << result.iterations
+                  << " iterations, diff = " << result.diff << std::endl;
+        if (!GraphSnapshot::isSnapshotFile(graph_filename)) {
+            updateDotFile(graph_filename, pageRanks);
+            return 0;
+        }
+        if (output.empty()) output = "data/pagerank_classic.csv";
+        if (output == graph_filename) {
+            std::cerr << "--output must not be the input snapshot" << std::endl;
+            return 1;
+        }
+        if (output.size() > 9 && output.compare(output.size() - 9, 9, ".snapshot") == 0) {
+            scaleToUnitMax(pageRanks);
+            updateSnapshotPageRank(graph_filename, pageRanks, output);
+        } else {
+            writeRankCsv(graph, pageRanks, output);
+        }
+        std::cout << "Ranks written to " << output << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "csr_graph.h"
+#include "pagerank_engine.h"
+#include "parallel.h"
+
+// Several PageRank variants over the same citation matrix, solved together. The ranks are
+// stored interleaved (x[v * K + j] is variant j at vertex v), so each iteration reads every
+// edge once for all K variants: one sparse matrix times dense N x K block instead of K
+// separate SpMVs. The variants differ in damping, starting vector and teleport vector:
+//   x_j' = d_j * (A x_j + danglingMass) + (1 - d_j) * t_j,  then x_j' /= sum(x_j')
+// Each variant converges on its own and is frozen from then on.
+
+enum class RankStart { Uniform, Citations };
+enum class RankTeleport { Uniform, YearDecay };
+
+// One column of the Nodes output, e.g. --ranking=citerank:damping=0.85,teleport=year,decay=4
+struct RankingVariant {
+    std::string name;
+    double damping = 0.99;
+    RankStart start = RankStart::Citations;
+    RankTeleport teleport = RankTeleport::Uniform;
+    double decayYears = 5.0;  // CiteRank tau: teleport weight exp(-(newest year - year) / tau)
+};
+
+// One variant as the batch engine sees it. An empty teleport means uniform 1 / N.
+struct BatchColumn {
+    double damping = 0.99;
+    std::vector<double> start;
+    std::vector<double> teleport;
+};
+
+// Parses "name[:key=value,...]" with keys damping, start (uniform|citations), teleport
+// (uniform|year) and decay. The name must be a plain identifier, as it becomes a column name.
+inline RankingVariant parseRankingVariant(const std::string& spec) {
+    RankingVariant variant;
+    size_t colon = spec.find(':');
+    variant.name = spec.substr(0, colon);
+    bool identifier = !variant.name.empty() && !std::isdigit(static_cast<unsigned char>(variant.name[0]));
+    for (char c : variant.name) identifier = identifier && (std::isalnum(static_cast<unsigned char>(c)) || c == '_');
+    if (!identifier) throw std::runtime_error("Ranking name must be letters, digits and '_': " + spec);
+
+    size_t pos = colon == std::string::npos ? spec.size() : colon + 1;
+    while (pos < spec.size()) {
+        size_t comma = std::min(spec.find(',', pos), spec.size());
+        std::string setting = spec.substr(pos, comma - pos);
+        pos = comma + 1;
+        size_t eq = setting.find('=');
+        if (eq == std::string::npos) throw std::runtime_error("Expected key=value in ranking " + spec + ": " + setting);
+        std::string key = setting.substr(0, eq);
+        std::string value = setting.substr(eq + 1);
+        if (key == "damping" || key == "decay") {
+            size_t used = 0;
+            double number = 0.0;
+            try {
+                number = std::stod(value, &used);
+            } catch (const std::exception&) {
+            }
+            if (used != value.size() || !(number > 0)) throw std::runtime_error("Bad " + key + " in ranking " + spec);
+            if (key == "damping" && number >= 1) throw std::runtime_error("Damping must be below 1 in ranking " + spec);
+            (key == "damping" ? variant.damping : variant.decayYears) = number;
+        } else if (key == "start" && (value == "uniform" || value == "citations")) {
+            variant.start = value == "uniform" ? RankStart::Uniform : RankStart::Citations;
+        } else if (key == "teleport" && (value == "uniform" || value == "year")) {
+            variant.teleport = value == "uniform" ? RankTeleport::Uniform : RankTeleport::YearDecay;
+        } else {
+            throw std::runtime_error("Unknown setting in ranking " + spec + ": " + setting);
+        }
+    }
+    return variant;
+}
+
+// CiteRank teleport: a random reader starts at recent papers more often, weight
+// exp(-(newest - year) / tau), normalized to sum 1. Papers without a year (0) count as the oldest.
+template <typename Years>
+std::vector<double> yearDecayTeleport(const Years& years, double decayYears) {
+    int newest = 0;
+    int oldest = 0;
+    for (int year : years) {
+        if (year <= 0) continue;
+        newest = std::max(newest, year);
+        oldest = oldest == 0 ? year : std::min(oldest, year);
+    }
+    std::vector<double> teleport;
+    teleport.reserve(years.size());
+    double sum = 0.0;
+    for (int year : years) {
+        int age = newest - (year > 0 ? year : oldest);
+        teleport.push_back(std::exp(-age / decayYears));
+        sum += teleport.back();
+    }
+    for (double& t : teleport) t /= sum;
+    return teleport;
+}
+
+// Start and teleport vectors of a variant over the snapshot's citation counts and years.
+template <typename Counts, typename Years>
+BatchColumn makeBatchColumn(const RankingVariant& variant, const Counts& citationCounts, const Years& years) {
+    BatchColumn column;
+    column.damping = variant.damping;
+    if (variant.start == RankStart::Citations) {
+        column.start = citationBiasedRanks(citationCounts);
+    } else {
+        column.start.assign(citationCounts.size(), 1.0 / std::max<size_t>(1, citationCounts.size()));
+    }
+    if (variant.teleport == RankTeleport::YearDecay) column.teleport = yearDecayTeleport(years, variant.decayYears);
+    return column;
+}
+
+// Same blocks, threads and two-pass iteration as PageRankEngine, widened to K columns; with one
+// column it reproduces PageRankEngine's double power solve bit for bit.
+class PageRankBatchEngine {
+public:
+    static constexpr size_t kMaxColumns = 16;
+
+    PageRankBatchEngine(const CsrView& pull, unsigned numThreads)
+        : pull_(pull), numThreads_(std::max(1u, numThreads)),
+          blockStart_(balancedVertexBlocks(pull, PageRankEngine::kMaxBlocks)) {
+        numThreads_ = static_cast<unsigned>(std::min<size_t>(numThreads_, numBlocks()));
+    }
+
+    size_t numBlocks() const { return blockStart_.size() - 1; }
+
+    // Solves every column with the shared settings in options (iterations, tolerance, dangling
+    // mass, normalization; damping comes from the column). Returns the ranks column by column
+    // and one result per column; edgesTouched counts each edge once per batched iteration.
+    std::vector<std::vector<double>> run(const std::vector<BatchColumn>& columns, const PageRankOptions& options,
+                                         std::vector<PageRankResult>& results) {
+        const size_t n = pull_.numNodes;
+        const size_t k = columns.size();
+        if (k > kMaxColumns) throw std::runtime_error("At most " + std::to_string(kMaxColumns) + " rankings per batch");
+        results.assign(k, PageRankResult());
+        std::vector<std::vector<double>> ranks(k, std::vector<double>(n, 0.0));
+        if (n == 0 || k == 0) return ranks;
+
+        x_.assign(n * k, 0.0);
+        y_.assign(n * k, 0.0);
+        uniformTeleport_.assign(k, 0.0);
+        scaledTeleport_.assign(k, std::vector<double>());
+        for (size_t j = 0; j < k; ++j) {
+            const BatchColumn& column = columns[j];
+            if (column.start.size() != n || (!column.teleport.empty() && column.teleport.size() != n)) {
+                throw std::runtime_error("Ranking start and teleport vectors must have one entry per paper");
+            }
+            for (size_t v = 0; v < n; ++v) x_[v * k + j] = column.start[v];
+            uniformTeleport_[j] = (1 - column.damping) / n;
+            if (!column.teleport.empty()) {
+                scaledTeleport_[j].resize(n);
+                for (size_t v = 0; v < n; ++v) scaledTeleport_[j][v] = (1 - column.damping) * column.teleport[v];
+            }
+        }
+        blockSums_.assign(numBlocks() * k, 0.0);
+        blockDiffs_.assign(numBlocks() * k, 0.0);
+
+        int iterations = solve(columns, options, results);
+        const std::vector<double>& latest = iterations % 2 == 1 ? y_ : x_;
+        for (size_t j = 0; j < k; ++j) {
+            for (size_t v = 0; v < n; ++v) ranks[j][v] = latest[v * k + j];
+            results[j].edgesTouched = static_cast<uint64_t>(iterations) * pull_.numEdges();
+        }
+        return ranks;
+    }
+
+private:
+    // Returns the number of batched iterations; the latest block is in y_ when it is odd.
+    int solve(const std::vector<BatchColumn>& columns, const PageRankOptions& options, std::vector<PageRankResult>& results) {
+        const size_t k = columns.size();
+        const size_t numBlocks = this->numBlocks();
+        int iterations = 0;
+        Barrier barrier(numThreads_);
+
+        runOnThreads(numThreads_, [&](unsigned thread) {
+            size_t firstBlock = numBlocks * thread / numThreads_;
+            size_t lastBlock = numBlocks * (thread + 1) / numThreads_;
+            double* current = x_.data();
+            double* next = y_.data();
+            double damping[kMaxColumns];
+            const double* teleport[kMaxColumns];
+            bool active[kMaxColumns];
+            for (size_t j = 0; j < k; ++j) {
+                damping[j] = columns[j].damping;
+                teleport[j] = scaledTeleport_[j].empty() ? nullptr : scaledTeleport_[j].data();
+                active[j] = true;
+            }
+            size_t remaining = k;
+
+            for (int iteration = 0; iteration < options.maxIterations && remaining > 0; ++iteration) {
+                for (size_t b = firstBlock; b < lastBlock; ++b) {
+                    double sum[kMaxColumns] = {};
+                    for (uint32_t v = blockStart_[b]; v < blockStart_[b + 1]; ++v) {
+                        double pulled[kMaxColumns] = {};
+                        for (uint64_t e = pull_.offsets[v]; e < pull_.offsets[v + 1]; ++e) {
+                            const double* row = current + static_cast<size_t>(pull_.neighbors[e]) * k;
+                            for (size_t j = 0; j < k; ++j) pulled[j] += row[j];
+                        }
+                        double* out = next + static_cast<size_t>(v) * k;
+                        for (size_t j = 0; j < k; ++j) {
+                            double t = teleport[j] ? teleport[j][v] : uniformTeleport_[j];
+                            out[j] = damping[j] * (pulled[j] + options.danglingMass) + t;
+                            sum[j] += out[j];
+                        }
+                    }
+                    std::copy(sum, sum + k, blockSums_.begin() + b * k);
+                }
+                barrier.wait();
+
+                double scale[kMaxColumns];
+                for (size_t j = 0; j < k; ++j) {
+                    scale[j] = 1.0;
+                    if (!options.normalizeSum) continue;
+                    double total = 0.0;
+                    for (size_t b = 0; b < numBlocks; ++b) total += blockSums_[b * k + j];
+                    scale[j] = 1.0 / total;
+                }
+                for (size_t b = firstBlock; b < lastBlock; ++b) {
+                    double diff[kMaxColumns] = {};
+                    for (uint32_t v = blockStart_[b]; v < blockStart_[b + 1]; ++v) {
+                        double* out = next + static_cast<size_t>(v) * k;
+                        const double* in = current + static_cast<size_t>(v) * k;
+                        for (size_t j = 0; j < k; ++j) {
+                            // A converged column keeps its value, so the latest block holds every result
+                            if (!active[j]) {
+                                out[j] = in[j];
+                                continue;
+                            }
+                            out[j] *= scale[j];
+                            double delta = out[j] - in[j];
+                            diff[j] += options.l1Diff ? std::abs(delta) : delta * delta;
+                        }
+                    }
+                    std::copy(diff, diff + k, blockDiffs_.begin() + b * k);
+                }
+                barrier.wait();
+
+                // Every thread reads the same partials, so all of them freeze the same columns
+                for (size_t j = 0; j < k; ++j) {
+                    if (!active[j]) continue;
+                    double diff = 0.0;
+                    for (size_t b = 0; b < numBlocks; ++b) diff += blockDiffs_[b * k + j];
+                    if (!options.l1Diff) diff = std::sqrt(diff);
+                    if (thread == 0) {
+                        results[j].iterations = iteration + 1;
+                        results[j].diff = diff;
+                    }
+                    if (diff < options.tolerance) {
+                        active[j] = false;
+                        --remaining;
+                        if (thread == 0) results[j].converged = true;
+                    }
+                }
+                std::swap(current, next);
+                if (thread == 0) iterations = iteration + 1;
+            }
+        });
+        return iterations;
+    }
+
+    CsrView pull_;
+    unsigned numThreads_;
+    std::vector<uint32_t> blockStart_;
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> uniformTeleport_;
+    std::vector<std::vector<double>> scaledTeleport_;
+    std::vector<double> blockSums_;
+    std::vector<double> blockDiffs_;
+};
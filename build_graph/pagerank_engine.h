@@ -0,0 +1,601 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PAGERANK_X86_KERNELS 1
+#endif
+
+#include "csr_graph.h"
+#include "parallel.h"
+
+// Double keeps today's results bit for bit. Float halves the bytes gathered per edge; sums,
+// normalization and the convergence test stay in double.
+enum class PageRankPrecision { Double, Float };
+
+// Kernel for the float SpMV. Auto uses AVX2 when the CPU has it: on the citation graphs we
+// measured, 16-wide AVX-512 gathers were no faster than 8-wide ones (the SpMV is bound by
+// random reads), so AVX-512 is only used when asked for.
+enum class SimdLevel { Auto, Scalar, Avx2, Avx512 };
+
+// Power iterates the whole vector every step (multithreaded). GaussSeidel updates the vertices
+// in place, in topological order where there is one, so new values feed the rest of the sweep.
+// Push keeps a residual per vertex and only settles vertices whose residual is still large.
+// Both converge to the power fixed point in fewer edge traversals and run on the calling thread.
+enum class PageRankSolver { Power, GaussSeidel, Push };
+
+// Settings of one PageRank run. The defaults are the citation-biased variant main.cpp has
+// always computed:
+//   x' = d * (A x + danglingMass) + (1 - d) / N,  then x' /= sum(x')  (normalizeSum)
+// where row v of A pulls from the rows of the CSR the engine is built on, one term per edge,
+// optionally scaled by a per-source weight (1 / out-degree for textbook PageRank).
+struct PageRankOptions {
+    double damping = 0.99;
+    int maxIterations = 100;
+    double tolerance = 1e-9;
+    double danglingMass = 0.0;   // added to every row before damping
+    bool normalizeSum = true;    // rescale to sum 1 after every step
+    bool l1Diff = false;         // convergence on the L1 instead of the L2 distance
+    PageRankPrecision precision = PageRankPrecision::Double;
+    SimdLevel simd = SimdLevel::Auto;
+    PageRankSolver solver = PageRankSolver::Power;
+    std::function<void(int iteration, double diff)> onIteration;
+};
+
+struct PageRankResult {
+    int iterations = 0;
+    double diff = 0.0;
+    bool converged = false;
+    SimdLevel kernel = SimdLevel::Scalar;
+    uint64_t edgesTouched = 0;  // edge reads and pushes, to compare solvers independent of the machine
+};
+
+inline const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::Avx512: return "avx512";
+    case SimdLevel::Avx2: return "avx2";
+    case SimdLevel::Scalar: return "scalar";
+    default: return "auto";
+    }
+}
+
+inline const char* pageRankSolverName(PageRankSolver solver) {
+    switch (solver) {
+    case PageRankSolver::GaussSeidel: return "gauss-seidel";
+    case PageRankSolver::Push: return "push";
+    default: return "power";
+    }
+}
+
+namespace pagerank_detail {
+
+// Sum of x[idx[0..count)], accumulated in double.
+typedef double (*GatherSumFn)(const float* x, const uint32_t* idx, size_t count);
+
+inline double gatherSumScalar(const float* x, const uint32_t* idx, size_t count) {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) sum += x[idx[i]];
+    return sum;
+}
+
+inline double gatherSumScalar(const double* x, const uint32_t* idx, size_t count) {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) sum += x[idx[i]];
+    return sum;
+}
+
+#if defined(PAGERANK_X86_KERNELS)
+// GCC's AVX-512 headers trip -Wuninitialized on their own _mm512_undefined_* placeholders
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+// Vertex ids go through the signed 32-bit gather index, which covers graphs below 2^31 vertices.
+__attribute__((target("avx2"))) inline double gatherSumAvx2(const float* x, const uint32_t* idx, size_t count) {
+    __m256d low = _mm256_setzero_pd();
+    __m256d high = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx + i));
+        __m256 values = _mm256_i32gather_ps(x, indices, 4);
+        low = _mm256_add_pd(low, _mm256_cvtps_pd(_mm256_castps256_ps128(values)));
+        high = _mm256_add_pd(high, _mm256_cvtps_pd(_mm256_extractf128_ps(values, 1)));
+    }
+    __m256d both = _mm256_add_pd(low, high);
+    __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(both), _mm256_extractf128_pd(both, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+    for (; i < count; ++i) sum += x[idx[i]];
+    return sum;
+}
+
+__attribute__((target("avx512f"))) inline double gatherSumAvx512(const float* x, const uint32_t* idx, size_t count) {
+    __m512d low = _mm512_setzero_pd();
+    __m512d high = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512i indices = _mm512_loadu_si512(idx + i);
+        __m512 values = _mm512_i32gather_ps(indices, x, 4);
+        low = _mm512_add_pd(low, _mm512_cvtps_pd(_mm512_castps512_ps256(values)));
+        __m256 upper = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(values), 1));
+        high = _mm512_add_pd(high, _mm512_cvtps_pd(upper));
+    }
+    // Short rows (most citation lists) finish with a masked gather instead of a scalar loop
+    if (i < count) {
+        __mmask16 mask = static_cast<__mmask16>((1u << (count - i)) - 1);
+        __m512i indices = _mm512_maskz_loadu_epi32(mask, idx + i);
+        __m512 values = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), mask, indices, x, 4);
+        low = _mm512_add_pd(low, _mm512_cvtps_pd(_mm512_castps512_ps256(values)));
+        __m256 upper = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(values), 1));
+        high = _mm512_add_pd(high, _mm512_cvtps_pd(upper));
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(low, high));
+}
+
+#pragma GCC diagnostic pop
+#endif
+
+inline SimdLevel supportedSimdLevel() {
+#if defined(PAGERANK_X86_KERNELS)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::Avx512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::Avx2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+// Resolves a requested level to one this CPU can run (never wider than supported).
+inline SimdLevel resolveSimdLevel(SimdLevel requested) {
+    SimdLevel supported = supportedSimdLevel();
+    if (requested == SimdLevel::Auto) return supported == SimdLevel::Avx512 ? SimdLevel::Avx2 : supported;
+    return static_cast<int>(requested) <= static_cast<int>(supported) ? requested : supported;
+}
+
+inline GatherSumFn gatherKernel(SimdLevel level) {
+#if defined(PAGERANK_X86_KERNELS)
+    if (level == SimdLevel::Avx512) return gatherSumAvx512;
+    if (level == SimdLevel::Avx2) return gatherSumAvx2;
+#endif
+    return static_cast<GatherSumFn>(gatherSumScalar);
+}
+
+} // namespace pagerank_detail
+
+// Cuts the vertices of a CSR into at most maxBlocks runs of roughly equal edge + vertex count.
+// Returns the first vertex of every block plus numNodes at the end.
+inline std::vector<uint32_t> balancedVertexBlocks(const CsrView& csr, size_t maxBlocks) {
+    size_t n = csr.numNodes;
+    size_t numBlocks = std::max<size_t>(1, std::min(maxBlocks, n));
+    uint64_t totalWork = csr.numEdges() + n;
+    std::vector<uint32_t> blockStart(numBlocks + 1, static_cast<uint32_t>(n));
+    blockStart[0] = 0;
+    // Block b starts at the first vertex whose cumulative work reaches b / numBlocks of the total
+    uint32_t v = 0;
+    for (size_t b = 1; b < numBlocks; ++b) {
+        uint64_t target = totalWork * b / numBlocks;
+        while (v < n && csr.offsets[v] + v < target) ++v;
+        blockStart[b] = v;
+    }
+    return blockStart;
+}
+
+// Pull-based PageRank over a contiguous CSR. Vertices are cut into blocks of roughly equal
+// edge + vertex count, and every thread owns a contiguous run of blocks for the whole solve.
+// Each iteration is two passes separated by a barrier: SpMV plus the row sum, then
+// normalization plus the diff. Reductions go through per-block partials summed in block order,
+// so results do not depend on the thread count. All buffers are sized before the first
+// iteration; nothing is allocated inside the loop.
+class PageRankEngine {
+public:
+    static constexpr size_t kMaxBlocks = 4096;
+
+    PageRankEngine(const CsrView& pull, unsigned numThreads)
+        : pull_(pull), numThreads_(std::max(1u, numThreads)), blockStart_(balancedVertexBlocks(pull, kMaxBlocks)) {
+        numThreads_ = static_cast<unsigned>(std::min<size_t>(numThreads_, numBlocks()));
+    }
+
+    const CsrView& graph() const { return pull_; }
+    size_t numBlocks() const { return blockStart_.size() - 1; }
+    unsigned numThreads() const { return numThreads_; }
+
+    // Per-source multipliers for the pulled values, e.g. 1 / out-degree. Empty means 1.
+    void setSourceWeights(std::vector<double> weights) { sourceWeights_ = std::move(weights); }
+
+    // ranks holds the starting vector on entry and the result on return.
+    PageRankResult run(std::vector<double>& ranks, const PageRankOptions& options) {
+        const size_t n = pull_.numNodes;
+        ranks.resize(n, 0.0);
+        blockSums_.assign(numBlocks(), 0.0);
+        blockDiffs_.assign(numBlocks(), 0.0);
+        bool weighted = !sourceWeights_.empty();
+
+        if (options.solver != PageRankSolver::Power) {
+            if (options.precision != PageRankPrecision::Double) {
+                throw std::runtime_error("Float precision is only available for the power solver");
+            }
+            return options.solver == PageRankSolver::GaussSeidel ? solveGaussSeidel(ranks, options) : solvePush(ranks, options);
+        }
+
+        if (options.precision == PageRankPrecision::Double) {
+            next_.assign(n, 0.0);
+            contribution_.assign(weighted ? n : 0, 0.0);
+            double* x = ranks.data();
+            PageRankResult result = solve(x, next_.data(), weighted ? contribution_.data() : nullptr, options,
+                                          [](const double* src, const uint32_t* idx, size_t count) {
+                                              return pagerank_detail::gatherSumScalar(src, idx, count);
+                                          });
+            // After an odd number of iterations the latest vector is in next_
+            if (result.iterations % 2 == 1) ranks.swap(next_);
+            result.edgesTouched = static_cast<uint64_t>(result.iterations) * pull_.numEdges();
+            return result;
+        }
+
+        SimdLevel level = pagerank_detail::resolveSimdLevel(options.simd);
+        pagerank_detail::GatherSumFn kernel = pagerank_detail::gatherKernel(level);
+        floatRanks_.assign(ranks.begin(), ranks.end());
+        floatNext_.assign(n, 0.0f);
+        floatContribution_.assign(weighted ? n : 0, 0.0f);
+        PageRankResult result = solve(floatRanks_.data(), floatNext_.data(), weighted ? floatContribution_.data() : nullptr,
+                                      options, kernel);
+        result.kernel = level;
+        const std::vector<float>& latest = result.iterations % 2 == 1 ? floatNext_ : floatRanks_;
+        ranks.assign(latest.begin(), latest.end());
+        result.edgesTouched = static_cast<uint64_t>(result.iterations) * pull_.numEdges();
+        return result;
+    }
+
+private:
+    // With normalizeSum the power iteration is x' = normalize(d A x + k), k = d * danglingMass +
+    // (1 - d) / N, so its fixed point is the x with sum 1 solving lambda x = d A x + k where
+    // lambda = sum(d A x + k) is read off x itself. The in-place solvers update x towards
+    // (d A x + k) / lambda vertex by vertex and re-read lambda after every sweep (round).
+    // Without normalizeSum lambda is 1 and the problem is a plain linear system.
+    double prepareInPlace(std::vector<double>& ranks, const PageRankOptions& options, PageRankResult& result) {
+        const size_t n = pull_.numNodes;
+        if (pushGraph_.offsets.empty()) {
+            pushGraph_ = transposeCsr(pull_);
+            buildSweepOrder();
+            result.edgesTouched += 2 * pull_.numEdges();
+        }
+        // colWeight[u] sums the weights of the edges reading u, so sum(d A x) = d colWeight . x
+        columnWeight_.assign(n, 0.0);
+        for (uint32_t u = 0; u < n; ++u) {
+            columnWeight_[u] = pushGraph_.view().degree(u) * (sourceWeights_.empty() ? 1.0 : sourceWeights_[u]);
+        }
+        if (options.normalizeSum) normalizeToUnitSum(ranks);
+        next_.assign(n, 0.0);
+        return options.damping * options.danglingMass + (1 - options.damping) / n;
+    }
+
+    // Kahn's order on the pull graph: a vertex comes after every vertex it reads, so on a DAG one
+    // sweep solves the linear system exactly. Citation graphs are mostly acyclic; a cycle is
+    // broken by taking its lowest unplaced id.
+    void buildSweepOrder() {
+        const size_t n = pull_.numNodes;
+        CsrView push = pushGraph_.view();
+        sweepOrder_.clear();
+        sweepOrder_.reserve(n);
+        std::vector<uint32_t> pending(n);
+        std::vector<uint8_t> placed(n, 0);
+        for (uint32_t v = 0; v < n; ++v) {
+            pending[v] = pull_.degree(v);
+            if (pending[v] == 0) {
+                placed[v] = 1;
+                sweepOrder_.push_back(v);
+            }
+        }
+        uint32_t nextUnplaced = 0;
+        size_t head = 0;
+        while (sweepOrder_.size() < n) {
+            if (head == sweepOrder_.size()) {
+                while (placed[nextUnplaced]) ++nextUnplaced;
+                placed[nextUnplaced] = 1;
+                sweepOrder_.push_back(nextUnplaced);
+            }
+            uint32_t u = sweepOrder_[head++];
+            for (uint32_t v : push.neighborsOf(u)) {
+                if (!placed[v] && --pending[v] == 0) {
+                    placed[v] = 1;
+                    sweepOrder_.push_back(v);
+                }
+            }
+        }
+    }
+
+    double estimateLambda(const std::vector<double>& ranks, const PageRankOptions& options, double constant) const {
+        double weighted = 0.0;
+        double sum = 0.0;
+        for (size_t u = 0; u < ranks.size(); ++u) {
+            weighted += columnWeight_[u] * ranks[u];
+            sum += ranks[u];
+        }
+        return options.damping * weighted / sum + constant * ranks.size();
+    }
+
+    double pullRow(const std::vector<double>& ranks, uint32_t v) const {
+        double sum = 0.0;
+        if (sourceWeights_.empty()) {
+            for (uint32_t u : pull_.neighborsOf(v)) sum += ranks[u];
+        } else {
+            for (uint32_t u : pull_.neighborsOf(v)) sum += ranks[u] * sourceWeights_[u];
+        }
+        return sum;
+    }
+
+    static void normalizeToUnitSum(std::vector<double>& ranks) {
+        double sum = 0.0;
+        for (double r : ranks) sum += r;
+        if (sum > 0) {
+            for (double& r : ranks) r /= sum;
+        } else {
+            std::fill(ranks.begin(), ranks.end(), 1.0 / ranks.size());
+        }
+    }
+
+    // Ends a sweep or round: records it and reports whether x moved less than the tolerance
+    // since the copy in next_, measured like the power solver does.
+    bool finishStep(const std::vector<double>& ranks, const PageRankOptions& options, int iteration, PageRankResult& result) {
+        double diff = 0.0;
+        for (size_t v = 0; v < ranks.size(); ++v) {
+            double delta = ranks[v] - next_[v];
+            diff += options.l1Diff ? std::abs(delta) : delta * delta;
+        }
+        if (!options.l1Diff) diff = std::sqrt(diff);
+        result.iterations = iteration + 1;
+        result.diff = diff;
+        if (options.onIteration) options.onIteration(iteration, diff);
+        result.converged = diff < options.tolerance;
+        return result.converged;
+    }
+
+    PageRankResult solveGaussSeidel(std::vector<double>& ranks, const PageRankOptions& options) {
+        const size_t n = pull_.numNodes;
+        PageRankResult result;
+        if (n == 0) return result;
+        const double constant = prepareInPlace(ranks, options, result);
+        double lambda = options.normalizeSum ? estimateLambda(ranks, options, constant) : 1.0;
+
+        for (int iteration = 0; iteration < options.maxIterations; ++iteration) {
+            std::copy(ranks.begin(), ranks.end(), next_.begin());
+            for (uint32_t v : sweepOrder_) {
+                ranks[v] = (options.damping * pullRow(ranks, v) + constant) / lambda;
+            }
+            result.edgesTouched += pull_.numEdges();
+            if (options.normalizeSum) {
+                lambda = estimateLambda(ranks, options, constant);
+                normalizeToUnitSum(ranks);
+            }
+            if (finishStep(ranks, options, iteration, result)) break;
+        }
+        return result;
+    }
+
+    // Keeps the residual r = d A x + k - lambda x. Each round walks the sweep order and settles
+    // only the frontier of vertices whose |r| is above the mean (or the tolerance floor): x[v]
+    // takes r[v] / lambda and the vertices that read v get its effect added to their residuals.
+    // Rescaling x or moving lambda between rounds updates r in O(N) without touching edges, so
+    // vertices whose rank has stopped changing cost nothing.
+    PageRankResult solvePush(std::vector<double>& ranks, const PageRankOptions& options) {
+        const size_t n = pull_.numNodes;
+        PageRankResult result;
+        if (n == 0) return result;
+        const double constant = prepareInPlace(ranks, options, result);
+        CsrView push = pushGraph_.view();
+        double lambda = options.normalizeSum ? estimateLambda(ranks, options, constant) : 1.0;
+        residual_.resize(n);
+        for (uint32_t v = 0; v < n; ++v) {
+            residual_[v] = options.damping * pullRow(ranks, v) + constant - lambda * ranks[v];
+        }
+        result.edgesTouched += pull_.numEdges();
+
+        for (int iteration = 0; iteration < options.maxIterations; ++iteration) {
+            std::copy(ranks.begin(), ranks.end(), next_.begin());
+            double residualSum = 0.0;
+            for (double r : residual_) residualSum += std::abs(r);
+            // Below the floor, settling every vertex would move x by less than the tolerance in total
+            const double floor = options.tolerance * lambda / n;
+            const double threshold = std::max(floor, residualSum / n);
+            for (uint32_t v : sweepOrder_) {
+                if (std::abs(residual_[v]) <= threshold) continue;
+                double delta = residual_[v] / lambda;
+                ranks[v] += delta;
+                residual_[v] = 0.0;
+                double spread = options.damping * delta * (sourceWeights_.empty() ? 1.0 : sourceWeights_[v]);
+                for (uint32_t u : push.neighborsOf(v)) residual_[u] += spread;
+                result.edgesTouched += push.degree(v);
+            }
+
+            if (options.normalizeSum) {
+                double sum = 0.0;
+                for (double r : ranks) sum += r;
+                double nextLambda = estimateLambda(ranks, options, constant);
+                // For x / sum the residual becomes (r - k) / sum + k, minus the lambda step times x
+                for (uint32_t v = 0; v < n; ++v) {
+                    ranks[v] /= sum;
+                    residual_[v] = (residual_[v] - constant) / sum + constant - (nextLambda - lambda) * ranks[v];
+                }
+                lambda = nextLambda;
+            }
+            // A small step only counts once the whole frontier was settled, not just the worst of it
+            result.converged = finishStep(ranks, options, iteration, result) && threshold == floor;
+            if (result.converged) break;
+        }
+        return result;
+    }
+
+    // x holds the start vector; after k iterations the result is in x for even k, y for odd k.
+    // With source weights the SpMV pulls from contribution = x * weight instead of x.
+    template <typename Real, typename RowSum>
+    PageRankResult solve(Real* x, Real* y, Real* contribution, const PageRankOptions& options, RowSum rowSum) {
+        const size_t n = pull_.numNodes;
+        const size_t numBlocks = this->numBlocks();
+        PageRankResult result;
+        if (n == 0) return result;
+        const double teleport = (1 - options.damping) / n;
+        const double* weights = contribution ? sourceWeights_.data() : nullptr;
+        Barrier barrier(numThreads_);
+
+        runOnThreads(numThreads_, [&](unsigned thread) {
+            size_t firstBlock = numBlocks * thread / numThreads_;
+            size_t lastBlock = numBlocks * (thread + 1) / numThreads_;
+            Real* current = x;
+            Real* next = y;
+
+            if (weights) {
+                for (uint32_t v = blockStart_[firstBlock]; v < blockStart_[lastBlock]; ++v) {
+                    contribution[v] = static_cast<Real>(current[v] * weights[v]);
+                }
+                barrier.wait();
+            }
+            const Real* source = weights ? contribution : current;
+
+            for (int iteration = 0; iteration < options.maxIterations; ++iteration) {
+                for (size_t b = firstBlock; b < lastBlock; ++b) {
+                    double sum = 0.0;
+                    for (uint32_t v = blockStart_[b]; v < blockStart_[b + 1]; ++v) {
+                        double pulled = rowSum(source, pull_.neighbors + pull_.offsets[v], pull_.offsets[v + 1] - pull_.offsets[v]);
+                        Real value = static_cast<Real>(options.damping * (pulled + options.danglingMass) + teleport);
+                        next[v] = value;
+                        sum += value;
+                    }
+                    blockSums_[b] = sum;
+                }
+                barrier.wait();
+
+                double scale = 1.0;
+                if (options.normalizeSum) {
+                    double total = 0.0;
+                    for (double s : blockSums_) total += s;
+                    scale = 1.0 / total;
+                }
+                for (size_t b = firstBlock; b < lastBlock; ++b) {
+                    double diff = 0.0;
+                    for (uint32_t v = blockStart_[b]; v < blockStart_[b + 1]; ++v) {
+                        Real value = static_cast<Real>(next[v] * scale);
+                        next[v] = value;
+                        if (weights) contribution[v] = static_cast<Real>(value * weights[v]);
+                        double delta = static_cast<double>(value) - current[v];
+                        diff += options.l1Diff ? std::abs(delta) : delta * delta;
+                    }
+                    blockDiffs_[b] = diff;
+                }
+                barrier.wait();
+
+                double diff = 0.0;
+                for (double d : blockDiffs_) diff += d;
+                if (!options.l1Diff) diff = std::sqrt(diff);
+                std::swap(current, next);
+                if (!weights) source = current;
+                if (thread == 0) {
+                    result.iterations = iteration + 1;
+                    result.diff = diff;
+                    if (options.onIteration) options.onIteration(iteration, diff);
+                }
+                if (diff < options.tolerance) {
+                    if (thread == 0) result.converged = true;
+                    break;
+                }
+            }
+        });
+        return result;
+    }
+
+    CsrView pull_;
+    unsigned numThreads_;
+    std::vector<uint32_t> blockStart_;
+    std::vector<double> sourceWeights_;
+    std::vector<double> next_;
+    std::vector<double> contribution_;
+    std::vector<float> floatRanks_;
+    std::vector<float> floatNext_;
+    std::vector<float> floatContribution_;
+    std::vector<double> blockSums_;
+    std::vector<double> blockDiffs_;
+    std::vector<double> columnWeight_;
+    CsrGraph pushGraph_;
+    std::vector<uint32_t> sweepOrder_;
+    std::vector<double> residual_;
+};
+
+// Starting vector biased by citations: log(cc + 1) / log(maxcc + 1), normalized to sum 1.
+template <typename Counts>
+std::vector<double> citationBiasedRanks(const Counts& citationCounts) {
+    int maxCitations = 0;
+    for (int cc : citationCounts) maxCitations = std::max(maxCitations, cc);
+    std::vector<double> ranks;
+    ranks.reserve(citationCounts.size());
+    double sum = 0.0;
+    for (int cc : citationCounts) {
+        ranks.push_back(std::log(cc + 1) / std::log(maxCitations + 1));
+        sum += ranks.back();
+    }
+    for (double& r : ranks) r /= sum;
+    return ranks;
+}
+
+inline uint64_t countZeroDegree(const CsrView& csr) {
+    uint64_t count = 0;
+    for (uint32_t v = 0; v < csr.numNodes; ++v) count += csr.degree(v) == 0;
+    return count;
+}
+
+// Scales ranks so the largest is 1 and returns the (min, max) of the scaled values.
+inline std::pair<double, double> scaleToUnitMax(std::vector<double>& ranks) {
+    if (ranks.empty()) return {0.0, 0.0};
+    double maxRank = *std::max_element(ranks.begin(), ranks.end());
+    double scaleFactor = 1.0 / maxRank;
+    for (double& r : ranks) r *= scaleFactor;
+    auto bounds = std::minmax_element(ranks.begin(), ranks.end());
+    return {*bounds.first, *bounds.second};
+}
+
+// The k highest ranked vertices, best first (ties broken by vertex id).
+inline std::vector<uint32_t> topRanked(const std::vector<double>& ranks, size_t k) {
+    std::vector<uint32_t> order(ranks.size());
+    std::iota(order.begin(), order.end(), 0u);
+    k = std::min(k, order.size());
+    std::partial_sort(order.begin(), order.begin() + k, order.end(), [&](uint32_t a, uint32_t b) {
+        return ranks[a] != ranks[b] ? ranks[a] > ranks[b] : a < b;
+    });
+    order.resize(k);
+    return order;
+}
+
+// How far a ranking (e.g. from the float kernel) drifts from a baseline over the same vertices.
+struct RankingDrift {
+    double l1 = 0.0;          // sum |candidate - baseline|
+    double maxAbs = 0.0;      // largest single difference
+    double baselineL1 = 0.0;  // sum |baseline|, to put l1 in proportion
+    std::vector<std::pair<size_t, double>> topKOverlap; // (k, |top-k both| / k)
+};
+
+inline RankingDrift compareRankings(const std::vector<double>& baseline, const std::vector<double>& candidate,
+                                    const std::vector<size_t>& ks) {
+    RankingDrift drift;
+    size_t n = std::min(baseline.size(), candidate.size());
+    for (size_t v = 0; v < n; ++v) {
+        double delta = std::abs(candidate[v] - baseline[v]);
+        drift.l1 += delta;
+        drift.maxAbs = std::max(drift.maxAbs, delta);
+        drift.baselineL1 += std::abs(baseline[v]);
+    }
+    for (size_t k : ks) {
+        k = std::min(k, n);
+        if (k == 0) continue;
+        std::vector<uint32_t> expected = topRanked(baseline, k);
+        std::vector<uint32_t> actual = topRanked(candidate, k);
+        std::unordered_set<uint32_t> expectedSet(expected.begin(), expected.end());
+        size_t shared = 0;
+        for (uint32_t v : actual) shared += expectedSet.count(v);
+        drift.topKOverlap.emplace_back(k, static_cast<double>(shared) / k);
+    }
+    return drift;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Per-vertex attributes that graph algorithms read, one contiguous array per attribute,
+// indexed by dense vertex id.
+struct PaperColumns {
+    std::vector<int> year;
+    std::vector<int> citationCount;
+    std::vector<double> pageRank;
+
+    size_t size() const { return year.size(); }
+
+    // Appends a vertex and returns its id
+    uint32_t add(int paperYear, int paperCitationCount) {
+        year.push_back(paperYear);
+        citationCount.push_back(paperCitationCount);
+        pageRank.push_back(0.0);
+        return static_cast<uint32_t>(year.size() - 1);
+    }
+
+    size_t memoryBytes() const {
+        return year.capacity() * sizeof(int) + citationCount.capacity() * sizeof(int) + pageRank.capacity() * sizeof(double);
+    }
+};
+
+// Location of one vertex's title, url and abstract (stored back to back) in a text arena.
+struct PaperTextEntry {
+    uint64_t offset;
+    uint32_t titleLength;
+    uint32_t urlLength;
+    uint32_t abstractLength;
+    uint32_t reserved;
+};
+
+// Title, url and abstract of every vertex, stored back to back in one text arena.
+// Only the export stage reads these, so they stay out of the way of traversals.
+class PaperMetadataStore {
+public:
+    size_t size() const { return entries_.size(); }
+
+    // Sets the text of vertex v (appending v if needed). Replaced text is not reclaimed.
+    void set(uint32_t v, std::string_view title, std::string_view url, std::string_view abstract) {
+        if (v >= entries_.size()) entries_.resize(v + 1, PaperTextEntry{0, 0, 0, 0, 0});
+        PaperTextEntry& entry = entries_[v];
+        entry.offset = arena_.size();
+        entry.titleLength = static_cast<uint32_t>(title.size());
+        entry.urlLength = static_cast<uint32_t>(url.size());
+        entry.abstractLength = static_cast<uint32_t>(abstract.size());
+        arena_.append(title).append(url).append(abstract);
+    }
+
+    // Views are invalidated by the next set()
+    std::string_view title(uint32_t v) const {
+        const PaperTextEntry& entry = entries_[v];
+        return std::string_view(arena_.data() + entry.offset, entry.titleLength);
+    }
+    std::string_view url(uint32_t v) const {
+        const PaperTextEntry& entry = entries_[v];
+        return std::string_view(arena_.data() + entry.offset + entry.titleLength, entry.urlLength);
+    }
+    std::string_view abstract(uint32_t v) const {
+        const PaperTextEntry& entry = entries_[v];
+        return std::string_view(arena_.data() + entry.offset + entry.titleLength + entry.urlLength, entry.abstractLength);
+    }
+
+    const std::vector<PaperTextEntry>& entries() const { return entries_; }
+    const std::string& arena() const { return arena_; }
+    size_t memoryBytes() const { return arena_.capacity() + entries_.capacity() * sizeof(PaperTextEntry); }
+
+private:
+    std::string arena_;
+    std::vector<PaperTextEntry> entries_;
+};
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Interns Semantic Scholar paper ids as dense uint32_t ids (0, 1, 2, ... in first-seen order).
+// The usual 40-character lowercase hex ids are stored once, packed into 20 bytes of a single
+// arena and indexed by an open-addressing table of dense ids. Anything else (e.g. the
+// "unknown" placeholder) lives in a small side table.
+class PaperIdDictionary {
+public:
+    static constexpr uint32_t kInvalid = UINT32_MAX;
+    static constexpr size_t kHexLength = 40;
+    static constexpr size_t kPackedLength = 20;
+
+    size_t size() const { return arena_.size() / kPackedLength; }
+
+    void reserve(size_t n) {
+        arena_.reserve(n * kPackedLength);
+        size_t capacity = 16;
+        while (capacity < n * 2) capacity <<= 1;
+        if (capacity > slots_.size()) rehash(capacity);
+    }
+
+    // Returns the dense id of paperId, assigning the next one if it is new.
+    uint32_t intern(std::string_view paperId, bool* inserted = nullptr) {
+        uint8_t key[kPackedLength];
+        if (!pack(paperId, key)) return internOther(paperId, inserted);
+
+        if ((size() + 1) * 2 > slots_.size()) rehash(slots_.empty() ? 1024 : slots_.size() * 2);
+        size_t mask = slots_.size() - 1;
+        for (size_t slot = hash(key) & mask;; slot = (slot + 1) & mask) {
+            uint32_t dense = slots_[slot];
+            if (dense == kInvalid) {
+                dense = static_cast<uint32_t>(size());
+                arena_.insert(arena_.end(), key, key + kPackedLength);
+                slots_[slot] = dense;
+                if (inserted) *inserted = true;
+                return dense;
+            }
+            if (std::memcmp(packed(dense), key, kPackedLength) == 0) {
+                if (inserted) *inserted = false;
+                return dense;
+            }
+        }
+    }
+
+    // Returns the dense id of paperId, or kInvalid if it was never interned.
+    uint32_t find(std::string_view paperId) const {
+        uint8_t key[kPackedLength];
+        if (!pack(paperId, key)) {
+            auto it = otherIds_.find(std::string(paperId));
+            return it == otherIds_.end() ? kInvalid : it->second;
+        }
+        if (slots_.empty()) return kInvalid;
+        size_t mask = slots_.size() - 1;
+        for (size_t slot = hash(key) & mask;; slot = (slot + 1) & mask) {
+            uint32_t dense = slots_[slot];
+            if (dense == kInvalid) return kInvalid;
+            if (std::memcmp(packed(dense), key, kPackedLength) == 0) return dense;
+        }
+    }
+
+    // The original paper id string of a dense id.
+    std::string id(uint32_t dense) const {
+        if (!otherById_.empty()) {
+            auto it = otherById_.find(dense);
+            if (it != otherById_.end()) return it->second;
+        }
+        return unpack(packed(dense));
+    }
+
+    const uint8_t* packed(uint32_t dense) const { return arena_.data() + static_cast<size_t>(dense) * kPackedLength; }
+
+    // All packed ids back to back (zeroes for ids in otherIds())
+    const uint8_t* packedData() const { return arena_.data(); }
+    const std::unordered_map<uint32_t, std::string>& otherIds() const { return otherById_; }
+
+    size_t memoryBytes() const { return arena_.capacity() + slots_.capacity() * sizeof(uint32_t); }
+
+    // Only lowercase hex is packed, so unpack() reproduces the input exactly.
+    static bool pack(std::string_view paperId, uint8_t* key) {
+        if (paperId.size() != kHexLength) return false;
+        for (size_t i = 0; i < kPackedLength; ++i) {
+            int hi = hexValue(paperId[2 * i]);
+            int lo = hexValue(paperId[2 * i + 1]);
+            if (hi < 0 || lo < 0) return false;
+            key[i] = static_cast<uint8_t>(hi << 4 | lo);
+        }
+        return true;
+    }
+
+    static std::string unpack(const uint8_t* key) {
+        static const char digits[] = "0123456789abcdef";
+        std::string out(kHexLength, '0');
+        for (size_t i = 0; i < kPackedLength; ++i) {
+            out[2 * i] = digits[key[i] >> 4];
+            out[2 * i + 1] = digits[key[i] & 0xf];
+        }
+        return out;
+    }
+
+private:
+    static int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    // Paper ids are SHA-1 digests, so their leading bytes are already well mixed.
+    static size_t hash(const uint8_t* key) {
+        uint64_t h;
+        std::memcpy(&h, key, sizeof(h));
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+
+    void rehash(size_t capacity) {
+        slots_.assign(capacity, kInvalid);
+        size_t mask = capacity - 1;
+        for (uint32_t dense = 0; dense < size(); ++dense) {
+            if (otherById_.count(dense)) continue;
+            size_t slot = hash(packed(dense)) & mask;
+            while (slots_[slot] != kInvalid) slot = (slot + 1) & mask;
+            slots_[slot] = dense;
+        }
+    }
+
+    uint32_t internOther(std::string_view paperId, bool* inserted) {
+        auto result = otherIds_.emplace(std::string(paperId), static_cast<uint32_t>(size()));
+        if (inserted) *inserted = result.second;
+        if (result.second) {
+            // Keep the arena dense; the zeroed slot is never hashed
+            otherById_.emplace(result.first->second, result.first->first);
+            arena_.resize(arena_.size() + kPackedLength, 0);
+        }
+        return result.first->second;
+    }
+
+    std::vector<uint8_t> arena_;
+    std::vector<uint32_t> slots_;
+    std::unordered_map<std::string, uint32_t> otherIds_;
+    std::unordered_map<uint32_t, std::string> otherById_;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+inline unsigned defaultThreadCount() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// Runs fn(task, thread) for every task in [0, numTasks) on numThreads threads.
+// Tasks are handed out dynamically, so uneven task sizes still balance.
+template <typename Fn>
+void parallelFor(size_t numTasks, unsigned numThreads, Fn fn) {
+    numThreads = static_cast<unsigned>(std::min<size_t>(std::max(1u, numThreads), std::max<size_t>(1, numTasks)));
+    if (numThreads == 1) {
+        for (size_t task = 0; task < numTasks; ++task) fn(task, 0u);
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (unsigned t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (size_t task = next++; task < numTasks; task = next++) fn(task, t);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+}
+
+// Runs fn(thread) once on each of numThreads threads, the calling thread being thread 0.
+template <typename Fn>
+void runOnThreads(unsigned numThreads, Fn fn) {
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads > 0 ? numThreads - 1 : 0);
+    for (unsigned t = 1; t < numThreads; ++t) threads.emplace_back([&, t]() { fn(t); });
+    fn(0u);
+    for (auto& thread : threads) thread.join();
+}
+
+// Reusable barrier for a fixed group of threads (std::barrier is C++20).
+class Barrier {
+public:
+    explicit Barrier(unsigned count) : count_(count) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        unsigned generation = generation_;
+        if (++waiting_ == count_) {
+            waiting_ = 0;
+            ++generation_;
+            condition_.notify_all();
+            return;
+        }
+        condition_.wait(lock, [&] { return generation != generation_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    unsigned count_;
+    unsigned waiting_ = 0;
+    unsigned generation_ = 0;
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "bfs_tree.h"
+#include "csr_graph.h"
+#include "parallel.h"
+
+// Level-synchronous parallel BFS that switches between top-down and bottom-up steps (Beamer's
+// direction-optimizing BFS) for trees too large for BfsTreeBuilder: unlimited depth, or hub
+// papers whose frontier reaches a large part of the graph.
+//
+// Each level is found in parallel over a visited bitmap: top-down scans the out-rows of the
+// frontier, bottom-up the in-rows of the unvisited vertices against a frontier bitmap. Every new
+// vertex keeps the smallest (parent position, position in the parent's row) it was reached
+// with, and the level is appended in that order. That is exactly the tree BfsTreeBuilder
+// builds, vertex order, parents and levels included, so either can answer the same query.
+
+struct ParallelBfsStats {
+    uint32_t levels = 0;
+    uint32_t bottomUpLevels = 0;
+    uint64_t edgesScanned = 0;
+};
+
+class ParallelBfs {
+public:
+    // in must be the transpose of out
+    ParallelBfs(const CsrView& out, const CsrView& in, unsigned numThreads = defaultThreadCount())
+        : out_(out), in_(in), numThreads_(std::max(1u, numThreads)), visited_((out.numNodes + 63) / 64),
+          frontierBits_((out.numNodes + 63) / 64, 0), position_(out.numNodes, kUnvisited), keys_(out.numNodes) {
+        for (std::atomic<uint64_t>& word : visited_) word.store(0, std::memory_order_relaxed);
+        for (std::atomic<uint64_t>& key : keys_) key.store(kNoKey, std::memory_order_relaxed);
+        // Bottom-up steps need a vertex's place in its parent's row; with sorted rows that is its id
+        std::atomic<bool> sorted(true);
+        const size_t kRowsPerTask = 16384;
+        parallelFor((out.numNodes + kRowsPerTask - 1) / kRowsPerTask, numThreads_, [&](size_t task, unsigned) {
+            uint32_t end = static_cast<uint32_t>(std::min<size_t>(out.numNodes, (task + 1) * kRowsPerTask));
+            for (uint32_t v = static_cast<uint32_t>(task * kRowsPerTask); v < end && sorted.load(std::memory_order_relaxed); ++v) {
+                ArrayView<uint32_t> row = out.neighborsOf(v);
+                if (!std::is_sorted(row.begin(), row.end())) sorted = false;
+            }
+        });
+        rowsSorted_ = sorted;
+    }
+
+    // maxLevels < 0 means no limit. One build at a time per instance.
+    BfsTree build(uint32_t root, int maxLevels,
+                  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(),
+                  ParallelBfsStats* stats = nullptr) {
+        ParallelBfsStats local;
+        BfsTree tree;
+        tree.vertices.push_back(root);
+        tree.parents.push_back(root);
+        tree.levels.push_back(0);
+        claim(root);
+        position_[root] = 0;
+
+        const uint32_t n = out_.numNodes;
+        uint64_t frontierEdges = out_.degree(root);
+        uint64_t unvisitedEdges = in_.numEdges() - in_.degree(root);
+        bool bottomUp = false;
+        std::vector<std::vector<uint32_t>> found(numThreads_);
+        std::vector<uint32_t> next;
+        for (uint32_t level = 0, begin = 0; begin < tree.vertices.size(); ++level) {
+            uint32_t end = static_cast<uint32_t>(tree.vertices.size());
+            if (maxLevels >= 0 && level >= static_cast<uint32_t>(maxLevels)) break;
+            if (std::chrono::steady_clock::now() >= deadline) {
+                tree.timedOut = true;
+                break;
+            }
+            // Beamer's switch: bottom-up once the frontier's edges outweigh a fraction of the
+            // unvisited vertices' edges, back to top-down when the frontier is small again
+            uint32_t frontierSize = end - begin;
+            if (!bottomUp && frontierEdges > unvisitedEdges / kAlpha) bottomUp = true;
+            else if (bottomUp && frontierSize < n / kBeta) bottomUp = false;
+            bool parallel = (bottomUp ? unvisitedEdges : frontierEdges) > kParallelEdges;
+            unsigned threads = parallel ? numThreads_ : 1;
+            for (std::vector<uint32_t>& list : found) list.clear();
+
+            if (!bottomUp) {
+                const size_t kFrontierPerTask = 256;
+                parallelFor((frontierSize + kFrontierPerTask - 1) / kFrontierPerTask, threads, [&](size_t task, unsigned thread) {
+                    uint32_t last = std::min<uint32_t>(end, begin + static_cast<uint32_t>((task + 1) * kFrontierPerTask));
+                    for (uint32_t i = begin + static_cast<uint32_t>(task * kFrontierPerTask); i < last; ++i) {
+                        ArrayView<uint32_t> row = out_.neighborsOf(tree.vertices[i]);
+                        for (uint32_t j = 0; j < row.size(); ++j) {
+                            uint32_t v = row[j];
+                            if (position_[v] != kUnvisited) continue;  // on an earlier level
+                            if (!isVisited(v) && claim(v)) found[thread].push_back(v);
+                            lowerKey(v, static_cast<uint64_t>(i) << 32 | j);
+                        }
+                    }
+                });
+                local.edgesScanned += frontierEdges;
+            } else {
+                ++local.bottomUpLevels;
+                for (uint32_t i = begin; i < end; ++i) frontierBits_[tree.vertices[i] / 64] |= uint64_t(1) << (tree.vertices[i] % 64);
+                const size_t kWordsPerTask = 64;  // tasks own whole bitmap words
+                std::atomic<uint64_t> scanned(0);
+                parallelFor((visited_.size() + kWordsPerTask - 1) / kWordsPerTask, threads, [&](size_t task, unsigned thread) {
+                    uint64_t edges = 0;
+                    size_t lastWord = std::min(visited_.size(), (task + 1) * kWordsPerTask);
+                    for (size_t w = task * kWordsPerTask; w < lastWord; ++w) {
+                        uint64_t unvisited = ~visited_[w].load(std::memory_order_relaxed);
+                        uint64_t claimed = 0;
+                        for (; unvisited; unvisited &= unvisited - 1) {
+                            uint32_t v = static_cast<uint32_t>(w * 64 + __builtin_ctzll(unvisited));
+                            if (v >= n) break;
+                            // The whole row: the parent is the earliest frontier vertex, not the first found
+                            uint32_t parent = kUnvisited;
+                            ArrayView<uint32_t> row = in_.neighborsOf(v);
+                            edges += row.size();
+                            for (uint32_t u : row) {
+                                if ((frontierBits_[u / 64] >> (u % 64) & 1) && (parent == kUnvisited || position_[u] < position_[parent])) {
+                                    parent = u;
+                                }
+                            }
+                            if (parent == kUnvisited) continue;
+                            claimed |= uint64_t(1) << (v % 64);
+                            found[thread].push_back(v);
+                            keys_[v].store(static_cast<uint64_t>(position_[parent]) << 32 | rankInRow(parent, v), std::memory_order_relaxed);
+                        }
+                        if (claimed) visited_[w].fetch_or(claimed, std::memory_order_relaxed);
+                    }
+                    scanned += edges;
+                });
+                for (uint32_t i = begin; i < end; ++i) frontierBits_[tree.vertices[i] / 64] = 0;
+                local.edgesScanned += scanned;
+            }
+
+            next.clear();
+            for (const std::vector<uint32_t>& list : found) next.insert(next.end(), list.begin(), list.end());
+            if (next.empty()) break;
+            ++local.levels;
+            appendLevel(tree, next, level, begin, end, frontierEdges, unvisitedEdges);
+            begin = end;
+        }
+        if (stats) *stats = local;
+
+        // Only the vertices of this tree were touched
+        for (uint32_t v : tree.vertices) {
+            visited_[v / 64].store(0, std::memory_order_relaxed);
+            position_[v] = kUnvisited;
+            keys_[v].store(kNoKey, std::memory_order_relaxed);
+        }
+        return tree;
+    }
+
+private:
+    static constexpr uint32_t kUnvisited = UINT32_MAX;
+    static constexpr uint64_t kNoKey = UINT64_MAX;
+    static constexpr uint64_t kAlpha = 14;  // Beamer et al.
+    static constexpr uint32_t kBeta = 24;
+    static constexpr uint64_t kParallelEdges = 1 << 16;  // levels with fewer edges to scan stay on one thread
+
+    bool isVisited(uint32_t v) const { return visited_[v / 64].load(std::memory_order_relaxed) >> (v % 64) & 1; }
+
+    // True for the thread that set the bit
+    bool claim(uint32_t v) {
+        uint64_t bit = uint64_t(1) << (v % 64);
+        return !(visited_[v / 64].fetch_or(bit, std::memory_order_relaxed) & bit);
+    }
+
+    void lowerKey(uint32_t v, uint64_t key) {
+        uint64_t current = keys_[v].load(std::memory_order_relaxed);
+        while (key < current && !keys_[v].compare_exchange_weak(current, key, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint32_t rankInRow(uint32_t parent, uint32_t v) const {
+        if (rowsSorted_) return v;
+        ArrayView<uint32_t> row = out_.neighborsOf(parent);
+        return static_cast<uint32_t>(std::find(row.begin(), row.end(), v) - row.begin());
+    }
+
+    // Appends the vertices found below level in BFS order: by parent position (a counting sort
+    // over the frontier), then by place in the parent's row
+    void appendLevel(BfsTree& tree, const std::vector<uint32_t>& next, uint32_t level, uint32_t begin, uint32_t end,
+                     uint64_t& frontierEdges, uint64_t& unvisitedEdges) {
+        std::vector<uint32_t> counts(end - begin + 1, 0);
+        for (uint32_t v : next) ++counts[(keys_[v].load(std::memory_order_relaxed) >> 32) - begin + 1];
+        for (size_t p = 1; p < counts.size(); ++p) counts[p] += counts[p - 1];
+        ordered_.resize(next.size());
+        for (uint32_t v : next) {
+            uint64_t key = keys_[v].load(std::memory_order_relaxed);
+            ordered_[counts[(key >> 32) - begin]++] = {key, v};
+        }
+        for (size_t from = 0; from < ordered_.size();) {
+            size_t to = from + 1;
+            while (to < ordered_.size() && ordered_[to].first >> 32 == ordered_[from].first >> 32) ++to;
+            if (to - from > 1) std::sort(ordered_.begin() + from, ordered_.begin() + to);
+            from = to;
+        }
+        frontierEdges = 0;
+        for (const auto& entry : ordered_) {
+            uint32_t v = entry.second;
+            position_[v] = static_cast<uint32_t>(tree.vertices.size());
+            tree.vertices.push_back(v);
+            tree.parents.push_back(tree.vertices[entry.first >> 32]);
+            tree.levels.push_back(level + 1);
+            frontierEdges += out_.degree(v);
+            unvisitedEdges -= in_.degree(v);
+        }
+    }
+
+    CsrView out_;
+    CsrView in_;
+    unsigned numThreads_;
+    bool rowsSorted_ = true;
+    std::vector<std::atomic<uint64_t>> visited_;
+    std::vector<uint64_t> frontierBits_;
+    std::vector<uint32_t> position_;  // in the tree being built, kUnvisited outside it
+    std::vector<std::atomic<uint64_t>> keys_;  // (parent position, place in its row) of the level being found
+    std::vector<std::pair<uint64_t, uint32_t>> ordered_;
+};
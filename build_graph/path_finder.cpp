@@ -1,148 +1,173 @@
+#include <chrono>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
 #include <vector>
 
-struct Node {
-    std::string label;
-    int year;
-    int citationCount;
-    double pageRank;
-    std::vector<int> outEdges;
-};
+#include "dot_graph_loader.h"
+#include "shortest_paths.h"
 
-void parseDotFile(const std::string& filename, std::unordered_map<int, Node>& nodes) {
-    std::ifstream infile(filename);
-    std::string line;
-    int lineNumber = 0;
+// Prints every shortest citation path between two papers (up to --max-paths), one path per
+// line as space-separated node ids. Directed paths follow citations from the older paper;
+// --undirected ignores the direction of the citations. --k=N prints the N shortest loopless
+// paths instead, optionally kept apart by --disjoint or --max-overlap. --year-slack=N only
+// searches papers published between the two endpoints, give or take N years. --bounds only
+// prints the landmark lower and upper bounds on the hop distance ("lower upper", upper -1 when
+// no landmark connects the two) without searching.
 
-    try {
-        while (std::getline(infile, line)) {
-            ++lineNumber;
-            if (line.find("->") != std::string::npos) {
-                std::stringstream ss(line);
-                int from, to;
-                char ignore;
-                ss >> from >> ignore >> ignore >> to;
-
-                nodes[from].outEdges.push_back(to);
-            } else if (line.find("[label=") != std::string::npos) {
-                std::stringstream ss;
-                ss << line;
-                while (line.find("];") == std::string::npos) {
-                    if (!std::getline(infile, line)) {
-                        throw std::runtime_error("Incomplete node definition at end of file.");
-                    }
-                    ss << line;
-                    ++lineNumber;
-                }
-
-                std::string fullLine = ss.str();
-                std::stringstream fullSS(fullLine);
-                int id;
-                fullSS >> id;
-                Node node;
-                size_t labelStart = fullLine.find("label=\"") + 7;
-                size_t labelEnd = fullLine.find("\",", labelStart);
-                node.label = fullLine.substr(labelStart, labelEnd - labelStart);
-
-                size_t yearStart = fullLine.find("year=\"") + 6;
-                size_t yearEnd = fullLine.find("\",", yearStart);
-                node.year = std::stoi(fullLine.substr(yearStart, yearEnd - yearStart));
-
-                size_t citationCountStart = fullLine.find("citationCount=\"") + 15;
-                size_t citationCountEnd = fullLine.find("\"]", citationCountStart);
-                node.citationCount = std::stoi(fullLine.substr(citationCountStart, citationCountEnd - citationCountStart));
+const size_t kMaxK = 100;
 
-                node.pageRank = 1.0;
-                nodes[id] = node;
-            }
+int main(int argc, char* argv[]) {
+    // g++ -std=c++17 -O2 -o find_path path_finder.cpp
+    ShortestPathOptions options;
+    KShortestPathOptions kOptions;
+    int yearSlack = -1;
+    bool boundsOnly = false;
+    bool kShortest = false;
+    bool maxExpanded = false;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--undirected") {
+            options.direction = PathDirection::Undirected;
+        } else if (arg.rfind("--max-paths=", 0) == 0) {
+            options.maxPaths = std::stoul(arg.substr(12));
+        } else if (arg.rfind("--k=", 0) == 0) {
+            kOptions.k = std::stoul(arg.substr(4));
+            kShortest = true;
+        } else if (arg == "--disjoint") {
+            kOptions.disjoint = true;
+            kShortest = true;
+        } else if (arg.rfind("--max-overlap=", 0) == 0) {
+            kOptions.maxOverlap = std::stod(arg.substr(14));
+            kShortest = true;
+        } else if (arg.rfind("--max-expanded=", 0) == 0) {
+            kOptions.maxExpanded = std::stoul(arg.substr(15));
+            maxExpanded = true;
+        } else if (arg == "--bounds") {
+            boundsOnly = true;
+        } else if (arg.rfind("--year-slack=", 0) == 0) {
+            yearSlack = std::stoi(arg.substr(13));
+        } else {
+            positional.push_back(arg);
         }
-    } catch (const std::exception& e) {
-        std::cerr << "Error parsing line " << lineNumber << ": " << line << std::endl;
-        std::cerr << "Exception: " << e.what() << std::endl;
-        exit(EXIT_FAILURE);
     }
-}
-
-bool dfs(int start, int end, const std::unordered_map<int, Node>& nodes,
-         std::vector<int>& currentPath, std::vector<std::vector<int>>& allPaths,
-         std::unordered_set<int>& visited, int depth, int maxDepth) {
-    if (depth > maxDepth) return false;
-
-    visited.insert(start);
-    currentPath.push_back(start);
-
-    if (start == end) {
-        allPaths.push_back(currentPath);
-        currentPath.pop_back();
-        visited.erase(start);
-        return true;
+    if (positional.size() != 4) {
+        std::cerr << "Usage: " << argv[0] << " <start_node_id> <end_node_id> <max_depth> <dot or snapshot file name>"
+                  << " [--undirected] [--max-paths=N] [--year-slack=N] [--bounds]"
+                  << " [--k=N [--disjoint] [--max-overlap=F] [--max-expanded=N]]" << std::endl;
+        return 1;
     }
-
-    bool found = false;
-    for (int neighbor : nodes.at(start).outEdges) {
-        if (visited.find(neighbor) == visited.end()) {
-            found = dfs(neighbor, end, nodes, currentPath, allPaths, visited, depth + 1, maxDepth) || found;
-        }
+    if (kShortest && (kOptions.k == 0 || kOptions.k > kMaxK)) {
+        std::cerr << "--k must be between 1 and " << kMaxK << std::endl;
+        return 1;
     }
-
-    currentPath.pop_back();
-    visited.erase(start);
-    return found;
-}
-
-bool iddfs(int start, int end, const std::unordered_map<int, Node>& nodes,
-           std::vector<std::vector<int>>& allPaths, int maxDepth) {
-    std::unordered_set<int> visited;
-    std::vector<int> currentPath;
-
-    for (int depth = 1; depth <= maxDepth; ++depth) {
-        if (dfs(start, end, nodes, currentPath, allPaths, visited, 0, depth)) {
-            return true;
-        }
+    if (maxExpanded && !kShortest) {
+        std::cerr << "--max-expanded only applies to --k, --disjoint and --max-overlap" << std::endl;
+        return 1;
     }
-    return false;
-}
 
-int main(int argc, char* argv[]) {
-    if (argc != 5) {
-        std::cerr << "Usage: " << argv[0] << " <start_node_id> <end_node_id> <max_depth> <dot file name>" << std::endl;
+    int start = std::stoi(positional[0]);
+    int end = std::stoi(positional[1]);
+    options.maxDepth = std::stoi(positional[2]);
+    std::string graph_filename = positional[3];
+
+    // From a DOT file the reachability index is only built for directed searches and the landmark
+    // distances (BFS from every landmark in three directions, more than one search saves) only for --bounds
+    DotGraphIndexes indexes;
+    indexes.reachability = options.direction == PathDirection::Directed && !boundsOnly;
+    indexes.landmarks = boundsOnly;
+    GraphSnapshot graph;
+    try {
+        graph = openGraph(graph_filename, indexes);
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading graph: " << e.what() << std::endl;
+        return 1;
+    }
+    if (!graph.contains(start) || !graph.contains(end)) {
+        std::cerr << "Node id out of range (graph has " << graph.numNodes() << " nodes)" << std::endl;
         return 1;
     }
-
-    int start = std::stoi(argv[1]);
-    int end = std::stoi(argv[2]);
-    int maxDepth = std::stoi(argv[3]);
-    std::string dot_filename = argv[4];
-
-    std::unordered_map<int, Node> nodes;
-    parseDotFile(dot_filename, nodes);
 
     // Ensure the path starts from the older paper
-    if (nodes[start].year > nodes[end].year) {
+    if (graph.year(start) > graph.year(end)) {
         std::swap(start, end);
     }
 
-    std::vector<std::vector<int>> allPaths;
+    if (yearSlack >= 0) {
+        std::pair<int, int> window = yearWindow(graph.year(start), graph.year(end), yearSlack);
+        options.minYear = kOptions.minYear = window.first;
+        options.maxYear = kOptions.maxYear = window.second;
+    }
 
-    if (iddfs(start, end, nodes, allPaths, maxDepth)) {
-        for (const auto& path : allPaths) {
-            for (size_t i = 0; i < path.size(); ++i) {
-                std::cout << path[i];
-                if (i < path.size() - 1) {
-                    std::cout << " ";
-                }
-            }
-            std::cout << std::endl;
+    auto begin = std::chrono::high_resolution_clock::now();
+    LandmarkOracle landmarks = graph.landmarks();
+    if (boundsOnly) {
+        if (landmarks.empty()) {
+            std::cerr << "No landmark distances in " << graph_filename << std::endl;
+            return 1;
+        }
+        DistanceBounds bounds = landmarks.bounds(start, end, options.direction == PathDirection::Undirected);
+        auto finish = std::chrono::high_resolution_clock::now();
+        std::cerr << "Landmark bounds from " << landmarks.numLandmarks() << " landmarks, "
+                  << std::chrono::duration<double, std::milli>(finish - begin).count() << " ms" << std::endl;
+        if (bounds.lower == DistanceBounds::kNoPath) {
+            std::cout << "No path found between the nodes." << std::endl;
+            return 1;
         }
+        std::cout << bounds.lower << " " << (bounds.upper == DistanceBounds::kNoPath ? -1 : static_cast<long long>(bounds.upper))
+                  << std::endl;
+        return 0;
+    }
+
+    std::vector<std::vector<uint32_t>> allPaths;
+    ReachabilityIndex reachability = graph.reachability();
+    size_t componentsVisited = 0;
+    if (options.direction == PathDirection::Directed && reachability.exact() &&
+        !reachability.reachable(start, end, &componentsVisited)) {
+        auto finish = std::chrono::high_resolution_clock::now();
+        std::cerr << "Reachability index: unreachable, " << componentsVisited << " components visited, "
+                  << std::chrono::duration<double, std::milli>(finish - begin).count() << " ms" << std::endl;
+    } else if (kShortest) {
+        kOptions.direction = options.direction;
+        kOptions.maxDepth = options.maxDepth;
+        KShortestPaths yen(graph.out(), graph.in());
+        yen.setYears(graph.years());
+        yen.setReachability(reachability);
+        yen.setLandmarks(landmarks);
+        KShortestPathStats stats;
+        allPaths = yen.find(start, end, kOptions, &stats);
+        auto finish = std::chrono::high_resolution_clock::now();
+        std::cerr << "k shortest paths: " << allPaths.size() << " of " << kOptions.k << ", " << stats.searches << " searches, "
+                  << stats.expanded << " papers expanded, " << stats.rejected << " too similar"
+                  << (stats.budgetExhausted ? ", expansion budget used up" : "") << ", "
+                  << std::chrono::duration<double, std::milli>(finish - begin).count() << " ms" << std::endl;
     } else {
+        ShortestPathFinder finder(graph.out(), graph.in());
+        finder.setYears(graph.years());
+        finder.setReachability(reachability);
+        finder.setLandmarks(landmarks);
+        ShortestPathStats stats;
+        int length = finder.find(start, end, options, allPaths, &stats);
+        auto finish = std::chrono::high_resolution_clock::now();
+        std::cerr << "Bidirectional BFS: length " << length << ", " << allPaths.size() << (stats.truncated ? "+" : "")
+                  << " paths, " << stats.visited << " papers visited, " << stats.edgesScanned << " edges, " << stats.pruned
+                  << " pruned, "
+                  << std::chrono::duration<double, std::milli>(finish - begin).count() << " ms" << std::endl;
+    }
+
+    if (allPaths.empty()) {
         std::cout << "No path found between the nodes." << std::endl;
         return 1;
     }
+    for (const auto& path : allPaths) {
+        for (size_t i = 0; i < path.size(); ++i) {
+            std::cout << path[i];
+            if (i < path.size() - 1) {
+                std::cout << " ";
+            }
+        }
+        std::cout << std::endl;
+    }
 
     return 0;
 }
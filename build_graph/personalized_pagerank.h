@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+
+// PageRank personalized to one seed paper, approximated by local forward push (Andersen, Chung
+// and Lang): every vertex holds an estimate p and a residual r, the seed starts with r = 1, and
+// a vertex whose residual exceeds epsilon * degree keeps alpha * r and spreads the rest evenly
+// over its neighbors. The error of each estimate is below epsilon * degree, and the work is
+// O(1 / (alpha * epsilon)) regardless of the graph size. Walked over the in-edges (citers),
+// the estimates rank the papers building on the seed.
+struct PersonalizedPageRankOptions {
+    double alpha = 0.15;     // probability of jumping back to the seed, 1 - damping
+    double epsilon = 1e-6;   // residual per unit of degree left unpushed
+    size_t topK = 20;
+};
+
+struct PersonalizedPageRankStats {
+    size_t touched = 0;         // vertices that got any mass
+    size_t pushes = 0;
+    uint64_t edgesScanned = 0;
+    double residualLeft = 0.0;  // mass still unpushed when the query stopped
+};
+
+// State is dense per vertex but stamped with a query epoch, so a query only pays for the
+// vertices it touches and one instance can serve many queries.
+class PersonalizedPageRank {
+public:
+    explicit PersonalizedPageRank(const CsrView& walk)
+        : walk_(walk), estimate_(walk.numNodes, 0.0), residual_(walk.numNodes, 0.0), stamp_(walk.numNodes, 0) {}
+
+    // The topK vertices by estimate, best first (ties by vertex id), not counting the seed.
+    std::vector<std::pair<uint32_t, double>> topK(uint32_t seed, const PersonalizedPageRankOptions& options,
+                                                  PersonalizedPageRankStats* stats = nullptr) {
+        run(seed, options, stats);
+        std::vector<std::pair<uint32_t, double>> ranked;
+        ranked.reserve(touched_.size());
+        for (uint32_t v : touched_) {
+            if (v != seed && estimate_[v] > 0) ranked.emplace_back(v, estimate_[v]);
+        }
+        size_t k = std::min(options.topK, ranked.size());
+        std::partial_sort(ranked.begin(), ranked.begin() + k, ranked.end(),
+                          [](const std::pair<uint32_t, double>& a, const std::pair<uint32_t, double>& b) {
+                              return a.second != b.second ? a.second > b.second : a.first < b.first;
+                          });
+        ranked.resize(k);
+        return ranked;
+    }
+
+    // Runs the push from seed; estimate(v) is valid until the next query.
+    void run(uint32_t seed, const PersonalizedPageRankOptions& options, PersonalizedPageRankStats* stats = nullptr) {
+        if (++epoch_ == 0) {
+            std::fill(stamp_.begin(), stamp_.end(), 0);
+            epoch_ = 1;
+        }
+        touched_.clear();
+        queue_.clear();
+        PersonalizedPageRankStats local;
+
+        touch(seed);
+        residual_[seed] = 1.0;
+        queue_.push_back(seed);
+        // queue_ is FIFO via head; a vertex is queued when its residual crosses its threshold
+        for (size_t head = 0; head < queue_.size(); ++head) {
+            uint32_t u = queue_[head];
+            double r = residual_[u];
+            uint64_t degree = walk_.degree(u);
+            residual_[u] = 0.0;
+            estimate_[u] += options.alpha * r;
+            ++local.pushes;
+            if (degree == 0) continue; // nobody to pass the rest on to; it is dropped
+            double share = (1 - options.alpha) * r / degree;
+            for (uint32_t v : walk_.neighborsOf(u)) {
+                touch(v);
+                double threshold = options.epsilon * std::max<uint64_t>(1, walk_.degree(v));
+                bool below = residual_[v] <= threshold;
+                residual_[v] += share;
+                if (below && residual_[v] > threshold) queue_.push_back(v);
+            }
+            local.edgesScanned += degree;
+        }
+
+        local.touched = touched_.size();
+        for (uint32_t v : touched_) local.residualLeft += residual_[v];
+        if (stats) *stats = local;
+    }
+
+    double estimate(uint32_t v) const { return stamp_[v] == epoch_ ? estimate_[v] : 0.0; }
+    const std::vector<uint32_t>& touched() const { return touched_; }
+
+private:
+    void touch(uint32_t v) {
+        if (stamp_[v] == epoch_) return;
+        stamp_[v] = epoch_;
+        estimate_[v] = 0.0;
+        residual_[v] = 0.0;
+        touched_.push_back(v);
+    }
+
+    CsrView walk_;
+    std::vector<double> estimate_;
+    std::vector<double> residual_;
+    std::vector<uint32_t> stamp_;
+    uint32_t epoch_ = 0;
+    std::vector<uint32_t> touched_;
+    std::vector<uint32_t> queue_;
+};
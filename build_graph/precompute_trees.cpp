@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "dot_graph_loader.h"
+#include "parallel.h"
+#include "tree_store.h"
+
+// Batch mode for the tree view: builds the depth-limited BFS trees of the N papers with the
+// highest PageRank in parallel over one loaded graph and writes them to a tree store, which
+// graph_server maps to answer those TREE requests without a traversal.
+
+int main(int argc, char* argv[]) {
+    // g++ -std=c++17 -O2 -pthread -o precompute_trees precompute_trees.cpp
+    std::string graph_filename = "data/citation_network.snapshot";
+    std::string output = "data/bfs_trees.store";
+    size_t top = 1000;
+    int depth = 2;
+    unsigned threads = defaultThreadCount();
+    TreeFanOut fanOut;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--top=", 0) == 0) {
+            top = std::stoul(arg.substr(6));
+        } else if (arg.rfind("--depth=", 0) == 0) {
+            depth = std::stoi(arg.substr(8));
+        } else if (arg.rfind("--fan-out=", 0) == 0) {
+            fanOut.limit = static_cast<uint32_t>(std::stoul(arg.substr(10)));
+        } else if (arg.rfind("--by=", 0) == 0) {
+            if (!parseChildRanking(arg.substr(5), fanOut.ranking)) {
+                std::cerr << "Unknown ranking: " << arg.substr(5) << " (pageRank, citationCount, year, random or none)" << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--seed=", 0) == 0) {
+            fanOut.seed = std::stoull(arg.substr(7));
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            threads = static_cast<unsigned>(std::max(1, std::stoi(arg.substr(10))));
+        } else if (arg.rfind("--output=", 0) == 0) {
+            output = arg.substr(9);
+        } else if (arg.rfind("--", 0) != 0) {
+            graph_filename = arg;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [snapshot file name] [--top=1000] [--depth=2] [--fan-out=K]"
+                      << " [--by=pageRank|citationCount|year|random] [--seed=N] [--threads=N] [--output=data/bfs_trees.store]"
+                      << std::endl;
+            return 1;
+        }
+    }
+    if (depth < 0) {
+        std::cerr << "--depth must be at least 0" << std::endl;
+        return 1;
+    }
+
+    // A DOT file only gets the one order of references the trees are cut by
+    DotGraphIndexes indexes;
+    indexes.rankedOut = fanOut.ranking;
+    GraphSnapshot graph;
+    try {
+        graph = openGraph(graph_filename, indexes);
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading graph: " << e.what() << std::endl;
+        return 1;
+    }
+    CsrView ranked = graph.rankedOut(fanOut.ranking == ChildRanking::Random ? ChildRanking::None : fanOut.ranking);
+    if (ranked.numNodes != graph.numNodes()) {
+        std::cerr << "Snapshot has no " << childRankingName(fanOut.ranking) << " order, rebuild it with ./citation_network"
+                  << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> roots(graph.numNodes());
+    std::iota(roots.begin(), roots.end(), 0u);
+    top = std::min(top, roots.size());
+    std::partial_sort(roots.begin(), roots.begin() + top, roots.end(), [&](uint32_t a, uint32_t b) {
+        return graph.pageRank(a) > graph.pageRank(b) || (graph.pageRank(a) == graph.pageRank(b) && a < b);
+    });
+    roots.resize(top);
+
+    std::vector<BfsTree> trees(top);
+    threads = std::max(1u, threads);
+    std::vector<BfsTreeBuilder> builders(threads, BfsTreeBuilder(graph.out()));
+    parallelFor(top, threads, [&](size_t i, unsigned thread) { trees[i] = builders[thread].build(roots[i], depth, ranked, fanOut); });
+    auto built = std::chrono::steady_clock::now();
+
+    try {
+        writeTreeStore(output, graph.snapshotId(), depth, fanOut, roots, trees);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    size_t vertices = 0;
+    size_t largest = 0;
+    for (const BfsTree& tree : trees) {
+        vertices += tree.vertices.size();
+        largest = std::max(largest, tree.vertices.size());
+    }
+    std::cerr << "Precomputed " << top << " trees of depth " << depth;
+    if (fanOut.limit > 0) std::cerr << ", top " << fanOut.limit << " by " << childRankingName(fanOut.ranking);
+    std::cerr << ": " << vertices << " papers (largest tree " << largest << "), "
+              << (sizeof(TreeStoreHeader) + top * sizeof(TreeStoreEntry) + 2 * vertices * sizeof(uint32_t)) / 1024 << " KiB, built in "
+              << std::chrono::duration<double, std::milli>(built - start).count() << " ms on " << threads << " threads, written to "
+              << output << std::endl;
+    return 0;
+}
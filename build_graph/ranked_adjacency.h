@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "csr_graph.h"
+#include "parallel.h"
+
+// Adjacency rows re-sorted best first by a paper column, so the top k children of a vertex are
+// the first k entries of its row. The snapshot stores one such copy of the neighbor array per
+// ranking and direction next to the plain one; they share its offsets.
+
+enum class ChildRanking { None, PageRank, CitationCount, Year, Random };
+
+inline const char* childRankingName(ChildRanking ranking) {
+    switch (ranking) {
+        case ChildRanking::PageRank: return "pageRank";
+        case ChildRanking::CitationCount: return "citationCount";
+        case ChildRanking::Year: return "year";
+        case ChildRanking::Random: return "random";
+        default: return "none";
+    }
+}
+
+inline bool parseChildRanking(const std::string& name, ChildRanking& ranking) {
+    for (ChildRanking candidate : {ChildRanking::None, ChildRanking::PageRank, ChildRanking::CitationCount, ChildRanking::Year,
+                                   ChildRanking::Random}) {
+        if (name == childRankingName(candidate)) {
+            ranking = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Every row of graph sorted by key, highest first; ties keep the row order (ascending vertex id).
+template <typename Keys>
+std::vector<uint32_t> rankNeighbors(const CsrView& graph, const Keys& keys, unsigned numThreads = defaultThreadCount()) {
+    std::vector<uint32_t> ranked(graph.neighbors, graph.neighbors + graph.numEdges());
+    const size_t kRowsPerTask = 4096;
+    parallelFor((graph.numNodes + kRowsPerTask - 1) / kRowsPerTask, numThreads, [&](size_t task, unsigned) {
+        uint32_t end = static_cast<uint32_t>(std::min<size_t>(graph.numNodes, (task + 1) * kRowsPerTask));
+        for (uint32_t v = static_cast<uint32_t>(task * kRowsPerTask); v < end; ++v) {
+            std::stable_sort(ranked.begin() + graph.offsets[v], ranked.begin() + graph.offsets[v + 1],
+                             [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+        }
+    });
+    return ranked;
+}
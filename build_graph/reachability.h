@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "csr_graph.h"
+#include "parallel.h"
+
+// Strongly connected components of a CSR (Tarjan's algorithm with an explicit stack, so deep
+// citation chains cannot overflow the call stack). Components are numbered in reverse
+// topological order: for every edge u -> v, component[u] >= component[v], with equality only
+// inside a cycle. On an acyclic graph this is a topological order of the vertices.
+inline std::vector<uint32_t> stronglyConnectedComponents(const CsrView& graph, uint32_t* numComponents = nullptr) {
+    const uint32_t n = graph.numNodes;
+    const uint32_t kUnset = UINT32_MAX;
+    std::vector<uint32_t> component(n, kUnset);
+    std::vector<uint32_t> index(n, kUnset);
+    std::vector<uint32_t> low(n, 0);
+    std::vector<uint32_t> stack;
+    std::vector<std::pair<uint32_t, uint64_t>> calls;  // vertex, next edge to look at
+    uint32_t nextIndex = 0;
+    uint32_t nextComponent = 0;
+
+    for (uint32_t root = 0; root < n; ++root) {
+        if (index[root] != kUnset) continue;
+        index[root] = low[root] = nextIndex++;
+        stack.push_back(root);
+        calls.emplace_back(root, graph.offsets[root]);
+        while (!calls.empty()) {
+            uint32_t v = calls.back().first;
+            uint64_t edge = calls.back().second;
+            if (edge < graph.offsets[v + 1]) {
+                ++calls.back().second;
+                uint32_t w = graph.neighbors[edge];
+                if (index[w] == kUnset) {
+                    index[w] = low[w] = nextIndex++;
+                    stack.push_back(w);
+                    calls.emplace_back(w, graph.offsets[w]);
+                } else if (component[w] == kUnset) {
+                    low[v] = std::min(low[v], index[w]);
+                }
+                continue;
+            }
+            calls.pop_back();
+            if (!calls.empty()) low[calls.back().first] = std::min(low[calls.back().first], low[v]);
+            if (low[v] != index[v]) continue;
+            uint32_t w;
+            do {
+                w = stack.back();
+                stack.pop_back();
+                component[w] = nextComponent;
+            } while (w != v);
+            ++nextComponent;
+        }
+    }
+    if (numComponents) *numComponents = nextComponent;
+    return component;
+}
+
+// The DAG of components: an edge between two components when any of their members cite each
+// other. Rows are sorted and free of duplicates and self loops.
+inline CsrGraph condenseGraph(const CsrView& graph, const std::vector<uint32_t>& component, uint32_t numComponents) {
+    std::vector<std::pair<uint32_t, uint32_t>> edges;
+    for (uint32_t u = 0; u < graph.numNodes; ++u) {
+        for (uint32_t v : graph.neighborsOf(u)) {
+            if (component[u] != component[v]) edges.emplace_back(component[u], component[v]);
+        }
+    }
+    CsrGraph dag = buildCsr(numComponents, edges);
+    uint64_t kept = 0;
+    for (uint32_t c = 0; c < numComponents; ++c) {
+        auto begin = dag.neighbors.begin() + dag.offsets[c];
+        auto end = dag.neighbors.begin() + dag.offsets[c + 1];
+        std::sort(begin, end);
+        end = std::unique(begin, end);
+        dag.offsets[c] = kept;
+        kept = std::copy(begin, end, dag.neighbors.begin() + kept) - dag.neighbors.begin();
+    }
+    dag.offsets[numComponents] = kept;
+    dag.neighbors.resize(kept);
+    return dag;
+}
+
+// GRAIL (Yildirim et al.): each traversal is a DFS of the DAG with randomized root and child
+// order that labels component c with [low, post], its post-order number and the smallest one
+// below it. If a reaches b, b's interval lies inside a's in every traversal, so one traversal
+// without containment proves b unreachable. Labels are stored traversal-major per component:
+// labels[(c * traversals + i) * 2] = low, + 1 = post.
+inline void grailTraversal(const CsrView& dag, unsigned traversal, unsigned traversals, std::vector<uint32_t>& labels) {
+    const uint32_t n = dag.numNodes;
+    std::mt19937 rng(traversal * 7919 + 1);
+    std::vector<uint32_t> roots(n);
+    for (uint32_t c = 0; c < n; ++c) roots[c] = c;
+    std::shuffle(roots.begin(), roots.end(), rng);
+
+    std::vector<uint8_t> visited(n, 0);
+    // component, children left to look at, first child (children are walked cyclically from it)
+    struct Frame {
+        uint32_t component;
+        uint32_t remaining;
+        uint32_t first;
+    };
+    std::vector<Frame> stack;
+    uint32_t nextPost = 0;
+    auto low = [&](uint32_t c) -> uint32_t& { return labels[(static_cast<size_t>(c) * traversals + traversal) * 2]; };
+    auto post = [&](uint32_t c) -> uint32_t& { return labels[(static_cast<size_t>(c) * traversals + traversal) * 2 + 1]; };
+    auto enter = [&](uint32_t c) {
+        visited[c] = 1;
+        low(c) = UINT32_MAX;
+        uint32_t degree = dag.degree(c);
+        stack.push_back(Frame{c, degree, degree == 0 ? 0 : static_cast<uint32_t>(rng() % degree)});
+    };
+    for (uint32_t root : roots) {
+        if (visited[root]) continue;
+        enter(root);
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            uint32_t c = frame.component;
+            if (frame.remaining > 0) {
+                --frame.remaining;
+                uint32_t degree = dag.degree(c);
+                uint32_t child = dag.neighbors[dag.offsets[c] + (frame.first + frame.remaining) % degree];
+                if (!visited[child]) {
+                    enter(child);
+                } else {
+                    low(c) = std::min(low(c), low(child));
+                }
+                continue;
+            }
+            stack.pop_back();
+            post(c) = nextPost++;
+            low(c) = std::min(low(c), post(c));
+            if (!stack.empty()) low(stack.back().component) = std::min(low(stack.back().component), low(c));
+        }
+    }
+}
+
+const unsigned kGrailTraversals = 4;
+
+struct ReachabilityIndexStats {
+    uint32_t numComponents = 0;
+    uint64_t dagEdges = 0;
+    unsigned traversals = 0;
+    uint64_t bytes = 0;  // component ranks, DAG and labels
+    double buildMs = 0.0;
+};
+
+struct ReachabilityIndexData {
+    std::vector<uint32_t> componentRanks;
+    CsrGraph dag;
+    std::vector<uint32_t> labels;
+    ReachabilityIndexStats stats;
+};
+
+// SCCs, their condensation and GRAIL labels; the traversals run in parallel.
+inline ReachabilityIndexData buildReachabilityIndex(const CsrView& graph, unsigned traversals = kGrailTraversals,
+                                                    unsigned numThreads = defaultThreadCount()) {
+    auto start = std::chrono::steady_clock::now();
+    ReachabilityIndexData index;
+    uint32_t numComponents = 0;
+    index.componentRanks = stronglyConnectedComponents(graph, &numComponents);
+    index.dag = condenseGraph(graph, index.componentRanks, numComponents);
+    index.labels.assign(static_cast<size_t>(numComponents) * traversals * 2, 0);
+    CsrView dag = index.dag.view();
+    parallelFor(traversals, numThreads, [&](size_t traversal, unsigned) {
+        grailTraversal(dag, static_cast<unsigned>(traversal), traversals, index.labels);
+    });
+
+    ReachabilityIndexStats& stats = index.stats;
+    stats.numComponents = numComponents;
+    stats.dagEdges = index.dag.numEdges();
+    stats.traversals = traversals;
+    stats.bytes = index.componentRanks.size() * sizeof(uint32_t) + index.dag.offsets.size() * sizeof(uint64_t) +
+                  index.dag.neighbors.size() * sizeof(uint32_t) + index.labels.size() * sizeof(uint32_t);
+    stats.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return index;
+}
+
+// Reachability queries over the (memory-mapped) index. Works with the component ranks alone,
+// for snapshots without the DAG and labels; mayReach is then only the topological test and
+// reachable is not exact.
+class ReachabilityIndex {
+public:
+    ReachabilityIndex() = default;
+    ReachabilityIndex(ArrayView<uint32_t> componentRanks, const CsrView& dag, ArrayView<uint32_t> labels)
+        : ranks_(componentRanks), dag_(dag), labels_(labels) {
+        traversals_ = dag.numNodes == 0 ? 0 : static_cast<unsigned>(labels.size() / (2 * static_cast<size_t>(dag.numNodes)));
+        if (traversals_ == 0) dag_ = CsrView();
+    }
+
+    bool empty() const { return ranks_.empty(); }
+    bool exact() const { return traversals_ > 0; }
+
+    // False only when u cannot reach v; constant time
+    bool mayReach(uint32_t u, uint32_t v) const {
+        if (ranks_.empty()) return true;
+        return componentMayReach(ranks_[u], ranks_[v]);
+    }
+
+    // Whether u reaches v: a DFS of the component DAG that skips every component the labels rule
+    // out. visited, if given, receives the number of components it touched.
+    bool reachable(uint32_t u, uint32_t v, size_t* visited = nullptr) {
+        if (visited) *visited = 0;
+        if (!mayReach(u, v)) return false;
+        uint32_t from = ranks_[u];
+        uint32_t to = ranks_[v];
+        if (from == to || !exact()) return true;
+
+        if (stamp_.size() != dag_.numNodes) stamp_.assign(dag_.numNodes, 0);
+        if (++epoch_ == 0) {
+            std::fill(stamp_.begin(), stamp_.end(), 0);
+            epoch_ = 1;
+        }
+        stack_.assign(1, from);
+        stamp_[from] = epoch_;
+        size_t touched = 1;
+        bool found = false;
+        while (!stack_.empty() && !found) {
+            uint32_t c = stack_.back();
+            stack_.pop_back();
+            for (uint32_t child : dag_.neighborsOf(c)) {
+                if (child == to) {
+                    found = true;
+                    break;
+                }
+                if (stamp_[child] == epoch_ || !componentMayReach(child, to)) continue;
+                stamp_[child] = epoch_;
+                stack_.push_back(child);
+                ++touched;
+            }
+        }
+        if (visited) *visited = touched;
+        return found;
+    }
+
+private:
+    bool componentMayReach(uint32_t a, uint32_t b) const {
+        if (a == b) return true;
+        if (a < b) return false;
+        for (unsigned i = 0; i < traversals_; ++i) {
+            const uint32_t* la = labels_.data() + (static_cast<size_t>(a) * traversals_ + i) * 2;
+            const uint32_t* lb = labels_.data() + (static_cast<size_t>(b) * traversals_ + i) * 2;
+            if (lb[0] < la[0] || lb[1] > la[1]) return false;
+        }
+        return true;
+    }
+
+    ArrayView<uint32_t> ranks_;
+    CsrView dag_;
+    ArrayView<uint32_t> labels_;
+    unsigned traversals_ = 0;
+    std::vector<uint32_t> stamp_;
+    uint32_t epoch_ = 0;
+    std::vector<uint32_t> stack_;
+};
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Least recently used cache of query answers, bounded by the bytes it holds. The owner clears
+// it when it switches snapshots; every entry is also tagged with the snapshotId of the graph it
+// was computed on and a lookup with another id drops it, which covers answers a worker still on
+// the old snapshot inserts after the clear. Safe to share between threads.
+
+struct ResultCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;      // dropped to make room
+    uint64_t invalidations = 0;  // dropped because the snapshot changed
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+class ResultCache {
+public:
+    using Value = std::shared_ptr<const std::string>;
+
+    // maxBytes 0 disables the cache. A single answer larger than an eighth of it is not kept,
+    // so one huge tree cannot flush everything else.
+    explicit ResultCache(size_t maxBytes) : maxBytes_(maxBytes) {}
+
+    bool enabled() const { return maxBytes_ > 0; }
+    size_t maxBytes() const { return maxBytes_; }
+
+    // nullptr on a miss
+    Value find(const std::string& key, uint64_t version) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            ++stats_.misses;
+            return nullptr;
+        }
+        if (it->second->version != version) {
+            ++stats_.invalidations;
+            ++stats_.misses;
+            erase(it->second);
+            return nullptr;
+        }
+        entries_.splice(entries_.begin(), entries_, it->second);
+        ++stats_.hits;
+        return it->second->value;
+    }
+
+    void insert(const std::string& key, uint64_t version, Value value) {
+        size_t bytes = entryBytes(key, *value);
+        if (!enabled() || bytes > maxBytes_ / 8) return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) erase(it->second);
+        entries_.push_front(Entry{key, version, std::move(value), bytes});
+        index_.emplace(key, entries_.begin());
+        stats_.bytes += bytes;
+        while (stats_.bytes > maxBytes_) {
+            ++stats_.evictions;
+            erase(std::prev(entries_.end()));
+        }
+        stats_.entries = index_.size();
+    }
+
+    // Drops everything, e.g. after the server switched to a rebuilt snapshot
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.invalidations += entries_.size();
+        entries_.clear();
+        index_.clear();
+        stats_.entries = 0;
+        stats_.bytes = 0;
+    }
+
+    ResultCacheStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        uint64_t version;
+        Value value;
+        size_t bytes;
+    };
+
+    // Payload plus a rough allowance for the list node, the index entry and the key copies
+    static size_t entryBytes(const std::string& key, const std::string& value) { return 2 * key.size() + value.size() + 128; }
+
+    void erase(std::list<Entry>::iterator entry) {
+        stats_.bytes -= entry->bytes;
+        index_.erase(entry->key);
+        entries_.erase(entry);
+        stats_.entries = index_.size();
+    }
+
+    size_t maxBytes_;
+    mutable std::mutex mutex_;
+    std::list<Entry> entries_;  // most recently used first
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    ResultCacheStats stats_;
+};
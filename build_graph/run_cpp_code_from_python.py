@@ -1,11 +1,54 @@
+import os
+import socket
 import subprocess
 from fastapi import HTTPException
 parsed_dot_file_name = "data/output.dot"
+graph_snapshot_file_name = "data/citation_network.snapshot"
+graph_server_socket_name = "data/graph_server.sock"
 
 
-def run_bfs_cpp_generation(paper_id: int, depth: int):
+def graph_file_name():
+    # The binary snapshot is memory-mapped by the C++ tools; fall back to the DOT file if it was not built
+    if os.path.exists(graph_snapshot_file_name):
+        return graph_snapshot_file_name
+    return parsed_dot_file_name
+
+
+def graph_server_query(request, timeout=5.0):
+    # One request to a running ./graph_server; None when it is not running, so callers fall back
+    # to starting the tools. Returns the answer lines, or raises on an ERR answer.
+    if not os.path.exists(graph_server_socket_name):
+        return None
+    try:
+        with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as connection:
+            connection.settimeout(timeout)
+            connection.connect(graph_server_socket_name)
+            connection.sendall((request + "\n").encode())
+            reader = connection.makefile('r', encoding='utf-8', errors='replace')
+            status = reader.readline().rstrip('\n')
+            if not status.startswith('OK '):
+                raise HTTPException(status_code=500, detail=f"Graph server: {status}")
+            return [reader.readline().rstrip('\n') for _ in range(int(status[3:]))]
+    except OSError:
+        return None
+
+
+def bfs_tree_name(paper_id: int, depth: int, fan_out: int = 0, selection_criteria: str = "pageRank", seed: int = 0):
+    # File name graph_bfs writes the tree to, without the .dot/.svg/.json extension
+    name = f"{paper_id}_{depth}"
+    if fan_out > 0:
+        name += f"_top{fan_out}_{selection_criteria}" + (f"_{seed}" if selection_criteria == "random" else "")
+    return name
+
+
+def run_bfs_cpp_generation(paper_id: int, depth: int, fan_out: int = 0, selection_criteria: str = "pageRank", seed: int = 0):
+    # fan_out > 0 keeps the best fan_out references of every paper in the tree (by pageRank,
+    # citationCount or year, or a random sample drawn with seed) instead of trimming it afterwards
     executable = './graph_bfs'  # Path to the compiled executable
-    result = subprocess.run([executable, str(paper_id), str(depth), parsed_dot_file_name], capture_output=True, text=True)
+    args = [executable, str(paper_id), str(depth), graph_file_name()]
+    if fan_out > 0:
+        args += [f'--fan-out={fan_out}', f'--by={selection_criteria}', f'--seed={seed}']
+    result = subprocess.run(args, capture_output=True, text=True)
 
     if result.returncode != 0:
         print(f"Error running BFS generation: {result.stderr}")
@@ -14,23 +57,69 @@ def run_bfs_cpp_generation(paper_id: int, depth: int):
         print("Successful tree generation")
 
 
-def create_png_from_dot(paper_id: int, depth: int):
-    executable = "dot"
-    image_format = "-Tpng"
-    input_file = f"data/bfs_trees/bfs_tree_{paper_id}_{depth}.dot"
-    output_file = f"-o data/pngs/{paper_id}_{depth}.png"
-    result = subprocess.run([executable, image_format, input_file, output_file], capture_output=True, text=True)
+def get_bfs_tree(paper_id, depth: int, fan_out: int = 0, selection_criteria: str = "none", seed: int = 0):
+    # Tree edges from a running ./graph_server as (paper, parent, level) tuples in BFS order, read
+    # from its precomputed tree store for popular papers; None when the server is not running
+    request = f"TREE {paper_id} {depth}"
+    if fan_out > 0:
+        request += f" fan_out={fan_out} by={selection_criteria} seed={seed}"
+    lines = graph_server_query(request)
+    if lines is None:
+        return None
+    return [tuple(int(value) for value in line.split()) for line in lines]
+
+
+def create_tree_image(paper_id: int, depth: int, fan_out: int = 0, selection_criteria: str = "pageRank", seed: int = 0,
+                      image_format: str = "svg"):
+    # Lays the tree out by year in graph_bfs itself (no graphviz process): "svg" for an image,
+    # "json" for node boxes and edge polylines to draw client-side. Returns the file, or None
+    executable = './graph_bfs'
+    args = [executable, str(paper_id), str(depth), graph_file_name()]
+    if fan_out > 0:
+        args += [f'--fan-out={fan_out}', f'--by={selection_criteria}', f'--seed={seed}']
+    args.append(f'--format={image_format}')
+    result = subprocess.run(args, capture_output=True, text=True)
 
     if result.returncode != 0:
-        print(f"Error creating png from dot file: {result.stderr}")
-    else:
-        # print(f"Output: {result.stdout}")
-        print("Successful png generation")
+        print(f"Error creating tree image: {result.stderr}")
+        return None
+    print(f"Successful {image_format} generation")
+    return f"data/bfs_trees/bfs_tree_{bfs_tree_name(paper_id, depth, fan_out, selection_criteria, seed)}.{image_format}"
 
 
-def get_path_between_two_nodes(start_node, end_node, max_depth="10"):
+def get_path_between_two_nodes(start_node, end_node, max_depth="10", undirected=False, k=None, disjoint=False,
+                               max_overlap=None, year_slack=None):
     executable = './find_path'  # Path to the compiled executable for path finding
-    result = subprocess.run([executable, start_node, end_node, max_depth, parsed_dot_file_name], capture_output=True, text=True)
+    # Shortest paths only; undirected matches the Neo4j shortestPath((start)-[:CITES*..15]-(end)) query.
+    # With k: the k shortest alternative lineages, kept apart by disjoint or max_overlap (0..1)
+    # year_slack: only through papers published between the two, give or take that many years
+    request = f"PATH {start_node} {end_node} depth={max_depth}"
+    if undirected:
+        request += " undirected=1"
+    if year_slack is not None:
+        request += f" year_slack={year_slack}"
+    if k is not None:
+        request += f" k={k}" + (" disjoint=1" if disjoint else "")
+        if max_overlap is not None:
+            request += f" max_overlap={max_overlap}"
+    paths = graph_server_query(request)
+    if paths is not None:
+        if not paths:
+            return {"paths": None, "message": "No path found between the nodes."}
+        return {"paths": [path.split() for path in paths]}
+
+    args = [executable, start_node, end_node, max_depth, graph_file_name()]
+    if undirected:
+        args.append('--undirected')
+    if year_slack is not None:
+        args.append(f'--year-slack={year_slack}')
+    if k is not None:
+        args.append(f'--k={k}')
+        if disjoint:
+            args.append('--disjoint')
+        if max_overlap is not None:
+            args.append(f'--max-overlap={max_overlap}')
+    result = subprocess.run(args, capture_output=True, text=True)
 
     if result.returncode != 0:
         print(f"Error finding paths: {result.stderr}")
@@ -42,3 +131,34 @@ def get_path_between_two_nodes(start_node, end_node, max_depth="10"):
         else:
             paths_list = [path.split() for path in paths]
             return {"paths": paths_list}
+
+
+def get_hop_distance_bounds(start_node, end_node, undirected=False):
+    # Landmark bounds on the number of hops between two papers, no search; upper is None when unknown
+    args = ['./find_path', start_node, end_node, "0", graph_file_name(), '--bounds']
+    if undirected:
+        args.append('--undirected')
+    result = subprocess.run(args, capture_output=True, text=True)
+
+    if "No path found" in result.stdout:
+        return {"lower": None, "upper": None, "message": "No path found between the nodes."}
+    if result.returncode != 0:
+        print(f"Error estimating distance: {result.stderr}")
+        raise HTTPException(status_code=500, detail="Error estimating distance")
+    lower, upper = (int(value) for value in result.stdout.split())
+    return {"lower": lower, "upper": upper if upper >= 0 else None}
+
+
+def get_influential_derivatives(paper_id, num_papers=20):
+    # Citers ranked by PageRank personalized to paper_id (a Semantic Scholar id or a node id)
+    executable = './influential_derivatives'
+    result = subprocess.run([executable, str(paper_id), str(num_papers), graph_file_name()], capture_output=True, text=True)
+
+    if result.returncode != 0:
+        print(f"Error ranking derivatives: {result.stderr}")
+        raise HTTPException(status_code=500, detail="Error ranking derivatives")
+    derivatives = []
+    for line in result.stdout.splitlines():
+        node_id, semantic_id, score, year, title = line.split('\t', 4)
+        derivatives.append({'node_id': int(node_id), 'id': semantic_id, 'score': float(score), 'year': int(year), 'label': title})
+    return derivatives
@@ -0,0 +1,500 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+#include "csr_graph.h"
+#include "landmarks.h"
+#include "reachability.h"
+
+// Directed follows citations (citing -> cited) from the source to the target; Undirected
+// ignores the direction, like Neo4j's shortestPath((a)-[:CITES*..15]-(b)).
+enum class PathDirection { Directed, Undirected };
+
+struct ShortestPathOptions {
+    PathDirection direction = PathDirection::Directed;
+    int maxDepth = 15;       // longest path considered, in edges
+    size_t maxPaths = 1000;  // there can be exponentially many shortest paths between hub papers
+    size_t maxVisited = 0;   // give up after labeling this many vertices (checked per level), 0 = no limit
+    // With setYears: papers published outside [minYear, maxYear] are skipped (year 0, unknown, never is)
+    int minYear = INT_MIN;
+    int maxYear = INT_MAX;
+    // With setReachability, directed searches skip papers that cannot be between the endpoints
+    bool topologicalPruning = true;
+    // Give up once this passes (checked per level), e.g. a server's per-query timeout
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+};
+
+// A citation lineage between papers from years a and b only passes through papers published
+// in between; slack allows for preprints cited before their publication year.
+inline std::pair<int, int> yearWindow(int yearA, int yearB, int slack) {
+    return {std::min(yearA, yearB) - slack, std::max(yearA, yearB) + slack};
+}
+
+struct ShortestPathStats {
+    size_t visited = 0;         // vertices labeled by either search
+    uint64_t edgesScanned = 0;
+    bool truncated = false;     // more than maxPaths shortest paths exist
+    bool gaveUp = false;        // stopped by maxVisited or the deadline before the searches met
+    bool timedOut = false;      // the deadline passed
+    uint64_t pruned = 0;        // neighbors skipped by the year or topological window or the landmarks
+};
+
+// Bidirectional BFS: one search from the source over out-edges, one from the target over
+// in-edges (both over all edges when undirected), each level expanded on the side whose
+// frontier has fewer edges to scan. The first level on which the searches meet fixes the
+// length L; every shortest path then crosses the meeting level, so the paths are enumerated
+// from the forward BFS DAG up to the meeting vertices and the backward distances after them,
+// in lexicographic order of vertex ids. State is dense per vertex but stamped with a query
+// epoch, so one finder serves many queries and a query only pays for what it touches.
+// Banned vertices and first hops (see banVertex) let k-shortest-path searches reuse it.
+//
+// Pruning: a directed path only visits papers the source may reach and that may reach the
+// target (reachability.h: component ranks and GRAIL labels), which on the mostly acyclic
+// citation graph cuts the search to papers between the two in citation order and answers most
+// unreachable pairs without a search. The optional year window restricts it further.
+// Landmark bounds (landmarks.h) act as the A* heuristic: a vertex at depth d whose lower bound
+// to the other end exceeds the best known upper bound for the whole path minus d cannot be on a
+// shortest path, in either direction mode. Every pruning keeps all shortest paths.
+class ShortestPathFinder {
+public:
+    static constexpr uint32_t kUnreached = UINT32_MAX;
+
+    ShortestPathFinder(const CsrView& out, const CsrView& in)
+        : out_(out), in_(in), forwardStamp_(out.numNodes, 0), backwardStamp_(out.numNodes, 0), markStamp_(out.numNodes, 0),
+          forwardDist_(out.numNodes, 0), backwardDist_(out.numNodes, 0), vertexBan_(out.numNodes, 0),
+          firstHopBan_(out.numNodes, 0) {}
+
+    // Until clearBans(), paths may not pass through v, nor start with the edge source -> v
+    // (source being the one passed to find).
+    void banVertex(uint32_t v) {
+        vertexBan_[v] = banEpoch_;
+        bansActive_ = true;
+    }
+    void banFirstHop(uint32_t v) {
+        firstHopBan_[v] = banEpoch_;
+        bansActive_ = true;
+    }
+    // Per-vertex years (for ShortestPathOptions::minYear / maxYear) and the reachability index
+    // (for topologicalPruning); empty turns the pruning off.
+    void setYears(ArrayView<int32_t> years) { years_ = years; }
+    void setReachability(const ReachabilityIndex& reachability) { reachability_ = reachability; }
+    void setLandmarks(const LandmarkOracle& landmarks) { landmarks_ = landmarks; }
+
+    void clearBans() {
+        bansActive_ = false;
+        if (++banEpoch_ == 0) {
+            std::fill(vertexBan_.begin(), vertexBan_.end(), 0);
+            std::fill(firstHopBan_.begin(), firstHopBan_.end(), 0);
+            banEpoch_ = 1;
+        }
+    }
+
+    // Length in edges of the shortest path from source to target, or -1 when there is none
+    // within maxDepth. paths receives up to maxPaths shortest paths, each source first.
+    int find(uint32_t source, uint32_t target, const ShortestPathOptions& options, std::vector<std::vector<uint32_t>>& paths,
+             ShortestPathStats* stats = nullptr) {
+        nextEpoch();
+        paths.clear();
+        ShortestPathStats local;
+        undirected_ = options.direction == PathDirection::Undirected;
+        source_ = source;
+        target_ = target;
+        checkYears_ = !years_.empty() && (options.minYear != INT_MIN || options.maxYear != INT_MAX);
+        minYear_ = options.minYear;
+        maxYear_ = options.maxYear;
+        checkReach_ = !reachability_.empty() && !undirected_ && options.topologicalPruning;
+        if (checkReach_ && !reachability_.mayReach(source, target)) {
+            if (stats) *stats = ShortestPathStats();
+            return -1;
+        }
+        // Bans and the year window only make paths longer: the landmark upper bound no longer holds
+        depthBound_ = static_cast<uint32_t>(std::max(0, options.maxDepth));
+        if (!landmarks_.empty()) {
+            DistanceBounds bounds = landmarks_.bounds(source, target, undirected_);
+            if (bounds.lower > depthBound_) {
+                if (stats) *stats = ShortestPathStats();
+                return -1;
+            }
+            if (!bansActive_ && !checkYears_) depthBound_ = std::min(depthBound_, bounds.upper);
+        }
+
+        forwardFrontier_.assign(1, source);
+        backwardFrontier_.assign(1, target);
+        label(forwardStamp_, forwardDist_, source, 0);
+        label(backwardStamp_, backwardDist_, target, 0);
+        local.visited = source == target ? 1 : 2;
+        uint32_t forwardDepth = 0;
+        uint32_t backwardDepth = 0;
+        meeting_.clear();
+        if (source == target) meeting_.push_back(source);
+
+        while (meeting_.empty() && !forwardFrontier_.empty() && !backwardFrontier_.empty() &&
+               static_cast<int>(forwardDepth + backwardDepth) < options.maxDepth) {
+            if (options.maxVisited > 0 && local.visited >= options.maxVisited) {
+                local.gaveUp = true;
+                break;
+            }
+            if (options.deadline != std::chrono::steady_clock::time_point::max() &&
+                std::chrono::steady_clock::now() >= options.deadline) {
+                local.gaveUp = local.timedOut = true;
+                break;
+            }
+            bool forward = frontierEdges(forwardFrontier_, true) <= frontierEdges(backwardFrontier_, false);
+            if (forward) {
+                expand(forwardFrontier_, true, ++forwardDepth, local);
+            } else {
+                expand(backwardFrontier_, false, ++backwardDepth, local);
+            }
+        }
+        if (stats) *stats = local;
+        if (meeting_.empty()) return -1;
+
+        // Positions up to the meeting level follow the forward DAG towards a meeting vertex
+        uint32_t length = forwardDepth + backwardDepth;
+        meetingLevel_ = forwardDepth;
+        markAncestors();
+        path_.assign(1, source);
+        maxPaths_ = options.maxPaths;
+        paths_ = &paths;
+        truncated_ = false;
+        enumerate(source, 0, length);
+        if (stats) stats->truncated = truncated_;
+        return static_cast<int>(length);
+    }
+
+    // Distances of the last query: from the source (forward) and to the target (backward)
+    uint32_t forwardDistance(uint32_t v) const { return forwardStamp_[v] == epoch_ ? forwardDist_[v] : kUnreached; }
+    uint32_t backwardDistance(uint32_t v) const { return backwardStamp_[v] == epoch_ ? backwardDist_[v] : kUnreached; }
+
+private:
+    void nextEpoch() {
+        if (++epoch_ == 0) {
+            std::fill(forwardStamp_.begin(), forwardStamp_.end(), 0);
+            std::fill(backwardStamp_.begin(), backwardStamp_.end(), 0);
+            std::fill(markStamp_.begin(), markStamp_.end(), 0);
+            epoch_ = 1;
+        }
+    }
+
+    // v was reached at depth from the source (forward) or reaches the target in depth hops
+    bool inWindow(uint32_t v, bool forward, uint32_t depth) const {
+        if (checkYears_) {
+            int year = years_[v];
+            if (year > 0 && (year < minYear_ || year > maxYear_)) return false;
+        }
+        if (checkReach_ && !(forward ? reachability_.mayReach(v, target_) : reachability_.mayReach(source_, v))) return false;
+        if (landmarks_.empty()) return true;
+        uint32_t rest = (forward ? landmarks_.bounds(v, target_, undirected_) : landmarks_.bounds(source_, v, undirected_)).lower;
+        return rest != DistanceBounds::kNoPath && depth + rest <= depthBound_;
+    }
+
+    // from -> to in path order
+    bool allowed(uint32_t from, uint32_t to) const {
+        return vertexBan_[to] != banEpoch_ && vertexBan_[from] != banEpoch_ && (from != source_ || firstHopBan_[to] != banEpoch_);
+    }
+
+    void label(std::vector<uint32_t>& stamp, std::vector<uint32_t>& dist, uint32_t v, uint32_t d) {
+        stamp[v] = epoch_;
+        dist[v] = d;
+    }
+
+    // Neighbors in ascending id order: out-edges when forward, in-edges when not, both when
+    // undirected (merged, a citation in each direction counted once). fn returns false to stop.
+    template <typename Fn>
+    bool forEachNeighbor(uint32_t v, bool forward, Fn fn) const {
+        ArrayView<uint32_t> first = forward ? out_.neighborsOf(v) : in_.neighborsOf(v);
+        if (!undirected_) {
+            for (uint32_t u : first) {
+                if (!fn(u)) return false;
+            }
+            return true;
+        }
+        ArrayView<uint32_t> second = forward ? in_.neighborsOf(v) : out_.neighborsOf(v);
+        const uint32_t* a = first.begin();
+        const uint32_t* b = second.begin();
+        while (a != first.end() || b != second.end()) {
+            uint32_t u;
+            if (b == second.end() || (a != first.end() && *a < *b)) {
+                u = *a++;
+            } else if (a == first.end() || *b < *a) {
+                u = *b++;
+            } else {
+                u = *a++;
+                ++b;
+            }
+            if (!fn(u)) return false;
+        }
+        return true;
+    }
+
+    uint64_t frontierEdges(const std::vector<uint32_t>& frontier, bool forward) const {
+        uint64_t edges = 0;
+        for (uint32_t v : frontier) {
+            edges += forward || undirected_ ? out_.degree(v) : 0;
+            edges += !forward || undirected_ ? in_.degree(v) : 0;
+        }
+        return edges;
+    }
+
+    // Labels the next level of one search. Finishing the level after a meeting matters: every
+    // vertex of the level has to be labeled before the paths are enumerated.
+    void expand(std::vector<uint32_t>& frontier, bool forward, uint32_t depth, ShortestPathStats& stats) {
+        std::vector<uint32_t>& stamp = forward ? forwardStamp_ : backwardStamp_;
+        std::vector<uint32_t>& dist = forward ? forwardDist_ : backwardDist_;
+        const std::vector<uint32_t>& otherStamp = forward ? backwardStamp_ : forwardStamp_;
+        next_.clear();
+        for (uint32_t u : frontier) {
+            forEachNeighbor(u, forward, [&](uint32_t v) {
+                ++stats.edgesScanned;
+                if (stamp[v] == epoch_ || !(forward ? allowed(u, v) : allowed(v, u))) return true;
+                if (!inWindow(v, forward, depth)) {
+                    ++stats.pruned;
+                    return true;
+                }
+                label(stamp, dist, v, depth);
+                next_.push_back(v);
+                if (otherStamp[v] != epoch_) ++stats.visited;
+                else meeting_.push_back(v);
+                return true;
+            });
+        }
+        frontier.swap(next_);
+    }
+
+    // Marks the meeting vertices and everything before them on a shortest forward path
+    void markAncestors() {
+        next_.clear();
+        for (uint32_t v : meeting_) {
+            if (markStamp_[v] == epoch_ || forwardDistance(v) != meetingLevel_) continue;
+            markStamp_[v] = epoch_;
+            next_.push_back(v);
+        }
+        for (size_t head = 0; head < next_.size(); ++head) {
+            uint32_t v = next_[head];
+            uint32_t d = forwardDist_[v];
+            if (d == 0) continue;
+            forEachNeighbor(v, false, [&](uint32_t u) {
+                if (markStamp_[u] != epoch_ && forwardDistance(u) == d - 1 && allowed(u, v)) {
+                    markStamp_[u] = epoch_;
+                    next_.push_back(u);
+                }
+                return true;
+            });
+        }
+    }
+
+    // Depth-first over the shortest-path DAG; returns false once maxPaths paths are collected
+    // and one more was seen.
+    bool enumerate(uint32_t v, uint32_t position, uint32_t length) {
+        if (position == length) {
+            if (paths_->size() == maxPaths_) {
+                truncated_ = true;
+                return false;
+            }
+            paths_->push_back(path_);
+            return true;
+        }
+        uint32_t nextPosition = position + 1;
+        return forEachNeighbor(v, true, [&](uint32_t w) {
+            bool onPath = nextPosition <= meetingLevel_
+                              ? markStamp_[w] == epoch_ && forwardDist_[w] == nextPosition
+                              : backwardDistance(w) == length - nextPosition;
+            if (!onPath || !allowed(v, w)) return true;
+            path_.push_back(w);
+            bool more = enumerate(w, nextPosition, length);
+            path_.pop_back();
+            return more;
+        });
+    }
+
+    CsrView out_;
+    CsrView in_;
+    bool undirected_ = false;
+    uint32_t source_ = 0;
+    uint32_t target_ = 0;
+    ArrayView<int32_t> years_;
+    ReachabilityIndex reachability_;
+    LandmarkOracle landmarks_;
+    uint32_t depthBound_ = 0;
+    bool bansActive_ = false;
+    bool checkYears_ = false;
+    int minYear_ = INT_MIN;
+    int maxYear_ = INT_MAX;
+    bool checkReach_ = false;
+    std::vector<uint32_t> forwardStamp_;
+    std::vector<uint32_t> backwardStamp_;
+    std::vector<uint32_t> markStamp_;
+    std::vector<uint32_t> forwardDist_;
+    std::vector<uint32_t> backwardDist_;
+    uint32_t epoch_ = 0;
+    std::vector<uint32_t> vertexBan_;
+    std::vector<uint32_t> firstHopBan_;
+    uint32_t banEpoch_ = 1;
+    std::vector<uint32_t> forwardFrontier_;
+    std::vector<uint32_t> backwardFrontier_;
+    std::vector<uint32_t> next_;
+    std::vector<uint32_t> meeting_;
+    uint32_t meetingLevel_ = 0;
+    std::vector<uint32_t> path_;
+    std::vector<std::vector<uint32_t>>* paths_ = nullptr;
+    size_t maxPaths_ = 0;
+    bool truncated_ = false;
+};
+
+struct KShortestPathOptions {
+    PathDirection direction = PathDirection::Directed;
+    int maxDepth = 15;
+    size_t k = 5;
+    size_t maxExpanded = 200000;  // vertices labeled over all searches of one query
+    bool disjoint = false;        // no two paths share an intermediate paper
+    double maxOverlap = 1.0;      // most of a path's intermediate papers that may lie on an earlier path
+    int minYear = INT_MIN;        // year window, as in ShortestPathOptions
+    int maxYear = INT_MAX;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+};
+
+struct KShortestPathStats {
+    size_t searches = 0;       // shortest path searches run
+    size_t expanded = 0;       // vertices they labeled
+    size_t rejected = 0;       // paths skipped as too similar to an earlier one
+    bool budgetExhausted = false;  // by maxExpanded or the deadline
+    bool timedOut = false;
+};
+
+// Up to k loopless paths in order of length (ties by vertex ids), Yen's algorithm over the
+// bidirectional BFS: every path taken spawns one spur search per vertex, with the vertices
+// before the spur and the next hops of earlier paths sharing the same prefix banned. With
+// maxOverlap < 1, a path reusing more than that fraction of any earlier path's intermediate
+// papers is skipped but still spawns spurs, so the search moves on to different lineages.
+// disjoint runs successive shortest path searches with the intermediate papers of every path
+// found so far banned. maxExpanded bounds the total work, so hub pairs stay predictable.
+class KShortestPaths {
+public:
+    KShortestPaths(const CsrView& out, const CsrView& in) : finder_(out, in) {}
+
+    void setYears(ArrayView<int32_t> years) { finder_.setYears(years); }
+    void setReachability(const ReachabilityIndex& reachability) { finder_.setReachability(reachability); }
+    void setLandmarks(const LandmarkOracle& landmarks) { finder_.setLandmarks(landmarks); }
+
+    std::vector<std::vector<uint32_t>> find(uint32_t source, uint32_t target, const KShortestPathOptions& options,
+                                            KShortestPathStats* stats = nullptr) {
+        KShortestPathStats local;
+        std::vector<std::vector<uint32_t>> accepted;
+        if (options.k > 0) {
+            finder_.clearBans();
+            if (options.disjoint) {
+                findDisjoint(source, target, options, accepted, local);
+            } else {
+                findYen(source, target, options, accepted, local);
+            }
+            finder_.clearBans();
+        }
+        if (stats) *stats = local;
+        return accepted;
+    }
+
+private:
+    // Shortest path under the current bans, within what is left of the budget
+    bool search(uint32_t source, uint32_t target, int maxDepth, const KShortestPathOptions& options,
+                std::vector<uint32_t>& path, KShortestPathStats& stats) {
+        if (stats.expanded >= options.maxExpanded) {
+            stats.budgetExhausted = true;
+            return false;
+        }
+        ShortestPathOptions pathOptions;
+        pathOptions.direction = options.direction;
+        pathOptions.maxDepth = maxDepth;
+        pathOptions.maxPaths = 1;
+        pathOptions.maxVisited = options.maxExpanded - stats.expanded;
+        pathOptions.minYear = options.minYear;
+        pathOptions.maxYear = options.maxYear;
+        pathOptions.deadline = options.deadline;
+        ShortestPathStats pathStats;
+        finder_.find(source, target, pathOptions, found_, &pathStats);
+        ++stats.searches;
+        stats.expanded += pathStats.visited;
+        if (pathStats.gaveUp) stats.budgetExhausted = true;
+        if (pathStats.timedOut) stats.timedOut = true;
+        if (found_.empty()) return false;
+        path.swap(found_[0]);
+        return true;
+    }
+
+    void findDisjoint(uint32_t source, uint32_t target, const KShortestPathOptions& options,
+                      std::vector<std::vector<uint32_t>>& accepted, KShortestPathStats& stats) {
+        std::vector<uint32_t> path;
+        while (accepted.size() < options.k && search(source, target, options.maxDepth, options, path, stats)) {
+            for (size_t i = 1; i + 1 < path.size(); ++i) finder_.banVertex(path[i]);
+            // A direct citation has no intermediate paper; it can only be used once
+            if (path.size() == 2) finder_.banFirstHop(target);
+            accepted.push_back(path);
+            if (path.size() == 1) break;
+        }
+    }
+
+    void findYen(uint32_t source, uint32_t target, const KShortestPathOptions& options,
+                 std::vector<std::vector<uint32_t>>& accepted, KShortestPathStats& stats) {
+        // Candidates ordered by length, then vertex ids
+        auto shorter = [](const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+            return a.size() != b.size() ? a.size() < b.size() : a < b;
+        };
+        std::set<std::vector<uint32_t>, decltype(shorter)> candidates(shorter);
+        std::set<std::vector<uint32_t>> seen;
+        std::vector<std::vector<uint32_t>> taken;  // every path popped, accepted or not
+        std::vector<uint32_t> path;
+        if (!search(source, target, options.maxDepth, options, path, stats)) return;
+        seen.insert(path);
+        candidates.insert(path);
+
+        while (!candidates.empty() && accepted.size() < options.k) {
+            std::vector<uint32_t> current = *candidates.begin();
+            candidates.erase(candidates.begin());
+            taken.push_back(current);
+            if (similarToAccepted(current, accepted, options.maxOverlap)) {
+                ++stats.rejected;
+            } else {
+                accepted.push_back(current);
+                if (accepted.size() == options.k) break;
+            }
+
+            for (size_t i = 0; i + 1 < current.size() && !stats.budgetExhausted; ++i) {
+                finder_.clearBans();
+                for (const std::vector<uint32_t>& other : taken) {
+                    if (other.size() > i + 1 && std::equal(current.begin(), current.begin() + i + 1, other.begin())) {
+                        finder_.banFirstHop(other[i + 1]);
+                    }
+                }
+                for (size_t j = 0; j < i; ++j) finder_.banVertex(current[j]);
+                std::vector<uint32_t> spur;
+                if (!search(current[i], target, options.maxDepth - static_cast<int>(i), options, spur, stats)) continue;
+                std::vector<uint32_t> candidate(current.begin(), current.begin() + i);
+                candidate.insert(candidate.end(), spur.begin(), spur.end());
+                if (seen.insert(candidate).second) candidates.insert(std::move(candidate));
+            }
+        }
+    }
+
+    // Whether more than maxOverlap of path's intermediate papers lie on one accepted path
+    static bool similarToAccepted(const std::vector<uint32_t>& path, const std::vector<std::vector<uint32_t>>& accepted,
+                                  double maxOverlap) {
+        if (maxOverlap >= 1.0 || path.size() <= 2) return false;
+        std::vector<uint32_t> inner(path.begin() + 1, path.end() - 1);
+        std::sort(inner.begin(), inner.end());
+        for (const std::vector<uint32_t>& other : accepted) {
+            size_t shared = 0;
+            for (size_t i = 1; i + 1 < other.size(); ++i) {
+                shared += std::binary_search(inner.begin(), inner.end(), other[i]);
+            }
+            if (static_cast<double>(shared) > maxOverlap * inner.size()) return true;
+        }
+        return false;
+    }
+
+    ShortestPathFinder finder_;
+    std::vector<std::vector<uint32_t>> found_;
+};
@@ -0,0 +1,465 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "bfs_tree.h"
+#include "graph_snapshot.h"
+
+// Layered drawing of a BFS tree without graphviz, written as SVG or as JSON coordinates. The
+// publication years are the layers, oldest on top like the year scale of graph_bfs's DOT file,
+// and titles are wrapped into boxes as wrapLabel does.
+//
+// Sugiyama-style: an edge spanning several layers gets a bend point (dummy) on every layer in
+// between; each layer starts in depth-first order of the tree and barycenter sweeps then keep
+// the order with the fewest crossings; x puts every box as close to the mean of its neighbors
+// on the adjacent layer as the spacing allows (isotonic regression, so each pass is linear).
+
+struct TreeLayoutOptions {
+    size_t wrapWidth = 20;   // label line length, as graph_bfs wraps titles
+    double charWidth = 7.0;  // of the 12px SVG font
+    double lineHeight = 14.0;
+    double padding = 6.0;
+    double nodeGap = 12.0;   // between neighbors on a layer
+    double layerGap = 48.0;
+    double axisWidth = 56.0;  // year scale on the left
+    int sweeps = 8;           // crossing reduction passes, alternately down and up
+    int placementPasses = 4;
+};
+
+struct LayoutNode {
+    uint32_t vertex;
+    uint32_t layer;
+    std::vector<std::string> lines;
+    double x = 0.0;  // center
+    double y = 0.0;
+    double width = 0.0;
+    double height = 0.0;
+};
+
+struct LayoutEdge {
+    uint32_t parent;  // indices into TreeLayout::nodes
+    uint32_t child;
+    std::vector<std::pair<double, double>> points;  // from the parent's box to the child's
+};
+
+struct TreeLayout {
+    std::vector<LayoutNode> nodes;  // BFS order of the tree, the root first
+    std::vector<LayoutEdge> edges;
+    std::vector<int> years;         // of the layers, top down
+    std::vector<double> layerY;
+    double width = 0.0;
+    double height = 0.0;
+    size_t dummies = 0;
+    size_t crossings = 0;
+};
+
+// Words of label in lines that, like wrapLabel's, stay within maxWidth with a trailing space; a
+// longer word gets a line of its own.
+inline std::vector<std::string> wrapWords(std::string_view label, size_t maxWidth) {
+    std::vector<std::string> lines;
+    std::istringstream words{std::string(label)};
+    std::string line;
+    for (std::string word; words >> word;) {
+        if (!line.empty() && line.size() + word.size() + 2 > maxWidth) {
+            lines.push_back(line);
+            line.clear();
+        }
+        if (!line.empty()) line += ' ';
+        line += word;
+    }
+    if (!line.empty() || lines.empty()) lines.push_back(line);
+    return lines;
+}
+
+namespace tree_layout_detail {
+
+// Crossings between two adjacent layers: the lower positions of the edges, in upper order and
+// ascending per upper item, counted as inversions with a Fenwick tree
+inline size_t countCrossings(const std::vector<uint32_t>& lower, size_t lowerSize, std::vector<uint32_t>& tree) {
+    tree.assign(lowerSize + 1, 0);
+    size_t crossings = 0;
+    for (size_t i = 0; i < lower.size(); ++i) {
+        size_t notAfter = 0;
+        for (size_t p = lower[i] + 1; p > 0; p -= p & (~p + 1)) notAfter += tree[p];
+        crossings += i - notAfter;
+        for (size_t p = lower[i] + 1; p <= lowerSize; p += p & (~p + 1)) ++tree[p];
+    }
+    return crossings;
+}
+
+// Centers as close to desired as the order and the minimum distances allow (least squares):
+// x[i] - offset[i] must not decrease, which pool-adjacent-violators solves in one pass.
+inline void placeInOrder(const std::vector<double>& desired, const std::vector<double>& offset, std::vector<double>& x) {
+    struct Block {
+        double sum;
+        size_t count;
+    };
+    std::vector<Block> blocks;
+    for (size_t i = 0; i < desired.size(); ++i) {
+        blocks.push_back(Block{desired[i] - offset[i], 1});
+        while (blocks.size() > 1 && blocks[blocks.size() - 2].sum * blocks.back().count >
+                                        blocks.back().sum * blocks[blocks.size() - 2].count) {
+            blocks[blocks.size() - 2].sum += blocks.back().sum;
+            blocks[blocks.size() - 2].count += blocks.back().count;
+            blocks.pop_back();
+        }
+    }
+    x.resize(desired.size());
+    size_t i = 0;
+    for (const Block& block : blocks) {
+        for (size_t j = 0; j < block.count; ++j, ++i) x[i] = block.sum / block.count + offset[i];
+    }
+}
+
+}  // namespace tree_layout_detail
+
+inline TreeLayout layoutTree(const BfsTree& tree, const GraphSnapshot& graph, const TreeLayoutOptions& options = TreeLayoutOptions()) {
+    using namespace tree_layout_detail;
+    TreeLayout layout;
+    const uint32_t n = static_cast<uint32_t>(tree.vertices.size());
+    if (n == 0) return layout;
+
+    for (uint32_t v : tree.vertices) layout.years.push_back(graph.year(v));
+    std::sort(layout.years.begin(), layout.years.end());
+    layout.years.erase(std::unique(layout.years.begin(), layout.years.end()), layout.years.end());
+    const uint32_t numLayers = static_cast<uint32_t>(layout.years.size());
+
+    layout.nodes.resize(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        LayoutNode& node = layout.nodes[i];
+        node.vertex = tree.vertices[i];
+        int year = graph.year(node.vertex);
+        node.layer = static_cast<uint32_t>(std::lower_bound(layout.years.begin(), layout.years.end(), year) - layout.years.begin());
+        node.lines = wrapWords(graph.title(node.vertex), options.wrapWidth);
+        size_t longest = 0;
+        for (const std::string& line : node.lines) longest = std::max(longest, line.size());
+        node.width = longest * options.charWidth + 2 * options.padding;
+        node.height = node.lines.size() * options.lineHeight + 2 * options.padding;
+    }
+
+    // Parents as node indices (the children of a node follow each other in BFS order) and the
+    // depth-first order the layers start from
+    std::vector<uint32_t> parent(n, 0);
+    std::vector<uint32_t> firstChild(n + 1, n);
+    for (uint32_t i = 1, cursor = 0; i < n; ++i) {
+        while (tree.vertices[cursor] != tree.parents[i]) ++cursor;
+        parent[i] = cursor;
+        if (firstChild[cursor] == n) firstChild[cursor] = i;
+    }
+    std::vector<uint32_t> childEnd(n, 0);
+    for (uint32_t i = 1; i < n; ++i) childEnd[parent[i]] = i + 1;
+    std::vector<uint32_t> preorder(n, 0);
+    std::vector<uint32_t> stack(1, 0);
+    for (uint32_t next = 0; !stack.empty();) {
+        uint32_t i = stack.back();
+        stack.pop_back();
+        preorder[i] = next++;
+        if (firstChild[i] == n) continue;
+        for (uint32_t c = childEnd[i]; c-- > firstChild[i];) stack.push_back(c);
+    }
+
+    // Items are the nodes, then the dummies; links join items on adjacent layers (upper, lower)
+    std::vector<uint32_t> itemLayer;
+    std::vector<double> itemWidth;
+    std::vector<uint32_t> itemKey;
+    for (const LayoutNode& node : layout.nodes) {
+        itemLayer.push_back(node.layer);
+        itemWidth.push_back(node.width);
+    }
+    itemKey = preorder;
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+    std::vector<std::vector<uint32_t>> chains(n);  // dummies of the edge into each child, from the parent
+    for (uint32_t c = 1; c < n; ++c) {
+        uint32_t p = parent[c];
+        uint32_t from = layout.nodes[p].layer;
+        uint32_t to = layout.nodes[c].layer;
+        if (from == to) continue;
+        int step = to > from ? 1 : -1;
+        uint32_t previous = p;
+        for (uint32_t layer = from + step; layer != to; layer += step) {
+            uint32_t dummy = static_cast<uint32_t>(itemLayer.size());
+            itemLayer.push_back(layer);
+            itemWidth.push_back(0.0);
+            itemKey.push_back(preorder[c]);
+            chains[c].push_back(dummy);
+            links.emplace_back(step > 0 ? previous : dummy, step > 0 ? dummy : previous);
+            previous = dummy;
+        }
+        links.emplace_back(step > 0 ? previous : c, step > 0 ? c : previous);
+    }
+    const uint32_t numItems = static_cast<uint32_t>(itemLayer.size());
+    layout.dummies = numItems - n;
+
+    // Neighbors on the layer above and below, as CSR rows
+    std::vector<uint32_t> upBegin(numItems + 1, 0), downBegin(numItems + 1, 0);
+    for (const auto& link : links) {
+        ++upBegin[link.second + 1];
+        ++downBegin[link.first + 1];
+    }
+    for (uint32_t i = 0; i < numItems; ++i) {
+        upBegin[i + 1] += upBegin[i];
+        downBegin[i + 1] += downBegin[i];
+    }
+    std::vector<uint32_t> up(links.size()), down(links.size());
+    {
+        std::vector<uint32_t> upFill(upBegin.begin(), upBegin.end() - 1), downFill(downBegin.begin(), downBegin.end() - 1);
+        for (const auto& link : links) {
+            up[upFill[link.second]++] = link.first;
+            down[downFill[link.first]++] = link.second;
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> layers(numLayers);
+    for (uint32_t item = 0; item < numItems; ++item) layers[itemLayer[item]].push_back(item);
+    for (std::vector<uint32_t>& layer : layers) {
+        std::sort(layer.begin(), layer.end(), [&](uint32_t a, uint32_t b) {
+            return itemKey[a] != itemKey[b] ? itemKey[a] < itemKey[b] : a < b;
+        });
+    }
+    std::vector<uint32_t> position(numItems);
+    auto index = [&]() {
+        for (const std::vector<uint32_t>& layer : layers) {
+            for (uint32_t i = 0; i < layer.size(); ++i) position[layer[i]] = i;
+        }
+    };
+    std::vector<uint32_t> between;
+    std::vector<uint32_t> fenwick;
+    auto crossings = [&]() {
+        size_t total = 0;
+        for (uint32_t l = 0; l + 1 < numLayers; ++l) {
+            between.clear();
+            for (uint32_t item : layers[l]) {
+                size_t first = between.size();
+                for (uint32_t k = downBegin[item]; k < downBegin[item + 1]; ++k) between.push_back(position[down[k]]);
+                if (between.size() - first > 1) std::sort(between.begin() + first, between.end());
+            }
+            total += countCrossings(between, layers[l + 1].size(), fenwick);
+        }
+        return total;
+    };
+
+    // Crossing reduction: sort each layer by the mean position of its neighbors on the layer
+    // just swept; items without any keep their slot
+    index();
+    layout.crossings = crossings();
+    std::vector<std::vector<uint32_t>> best = layers;
+    std::vector<std::pair<double, uint32_t>> barycenters;  // (barycenter, old position): a stable sort
+    std::vector<uint32_t> previous;
+    for (int sweep = 0; sweep < options.sweeps && layout.crossings > 0; ++sweep) {
+        bool downward = sweep % 2 == 0;
+        const std::vector<uint32_t>& begin = downward ? upBegin : downBegin;
+        const std::vector<uint32_t>& neighbors = downward ? up : down;
+        for (uint32_t step = 1; step < numLayers; ++step) {
+            std::vector<uint32_t>& layer = layers[downward ? step : numLayers - 1 - step];
+            barycenters.clear();
+            for (uint32_t i = 0; i < layer.size(); ++i) {
+                uint32_t item = layer[i];
+                if (begin[item] == begin[item + 1]) continue;
+                double sum = 0.0;
+                for (uint32_t k = begin[item]; k < begin[item + 1]; ++k) sum += position[neighbors[k]];
+                barycenters.emplace_back(sum / (begin[item + 1] - begin[item]), i);
+            }
+            std::sort(barycenters.begin(), barycenters.end());
+            previous = layer;
+            for (uint32_t i = 0, next = 0; i < layer.size(); ++i) {
+                uint32_t item = previous[i];
+                if (begin[item] != begin[item + 1]) layer[i] = previous[barycenters[next++].second];
+                position[layer[i]] = i;
+            }
+        }
+        size_t count = crossings();
+        if (count < layout.crossings) {
+            layout.crossings = count;
+            best = layers;
+        }
+    }
+    layers.swap(best);
+    index();
+
+    // Coordinates: packed left to right, then pulled toward the neighbors on the layer above
+    // and below in turn
+    std::vector<double> x(numItems);
+    std::vector<double> desired, offset, placed;
+    for (const std::vector<uint32_t>& layer : layers) {
+        double right = 0.0;
+        for (size_t i = 0; i < layer.size(); ++i) {
+            double half = itemWidth[layer[i]] / 2;
+            x[layer[i]] = right + (i > 0 ? options.nodeGap : 0.0) + half;
+            right = x[layer[i]] + half;
+        }
+    }
+    for (int pass = 0; pass < 2 * options.placementPasses; ++pass) {
+        bool downward = pass % 2 == 0;
+        const std::vector<uint32_t>& begin = downward ? upBegin : downBegin;
+        const std::vector<uint32_t>& neighbors = downward ? up : down;
+        for (uint32_t step = 1; step < numLayers; ++step) {
+            const std::vector<uint32_t>& layer = layers[downward ? step : numLayers - 1 - step];
+            desired.assign(layer.size(), 0.0);
+            offset.assign(layer.size(), 0.0);
+            for (size_t i = 0; i < layer.size(); ++i) {
+                uint32_t item = layer[i];
+                double sum = 0.0;
+                for (uint32_t k = begin[item]; k < begin[item + 1]; ++k) sum += x[neighbors[k]];
+                desired[i] = begin[item] == begin[item + 1] ? x[item] : sum / (begin[item + 1] - begin[item]);
+                if (i > 0) offset[i] = offset[i - 1] + (itemWidth[layer[i - 1]] + itemWidth[item]) / 2 + options.nodeGap;
+            }
+            placeInOrder(desired, offset, placed);
+            for (size_t i = 0; i < layer.size(); ++i) x[layer[i]] = placed[i];
+        }
+    }
+    double left = 0.0, right = 0.0;
+    for (uint32_t item = 0; item < numItems; ++item) {
+        left = std::min(left, x[item] - itemWidth[item] / 2);
+        right = std::max(right, x[item] + itemWidth[item] / 2);
+    }
+    for (uint32_t item = 0; item < numItems; ++item) x[item] += options.axisWidth + options.nodeGap - left;
+    layout.width = right - left + options.axisWidth + 2 * options.nodeGap;
+
+    // Layers are as tall as their tallest box
+    layout.layerY.assign(numLayers, 0.0);
+    std::vector<double> layerHeight(numLayers, options.lineHeight);
+    for (const LayoutNode& node : layout.nodes) layerHeight[node.layer] = std::max(layerHeight[node.layer], node.height);
+    double top = options.layerGap / 2;
+    for (uint32_t l = 0; l < numLayers; ++l) {
+        layout.layerY[l] = top + layerHeight[l] / 2;
+        top += layerHeight[l] + options.layerGap;
+    }
+    layout.height = top - options.layerGap / 2;
+    for (uint32_t i = 0; i < n; ++i) {
+        layout.nodes[i].x = x[i];
+        layout.nodes[i].y = layout.layerY[layout.nodes[i].layer];
+    }
+
+    // Edges leave the parent's box toward the child and bend at the dummies
+    for (uint32_t c = 1; c < n; ++c) {
+        const LayoutNode& from = layout.nodes[parent[c]];
+        const LayoutNode& to = layout.nodes[c];
+        LayoutEdge edge{parent[c], c, {}};
+        if (from.layer == to.layer) {
+            double side = to.x > from.x ? 1.0 : -1.0;
+            edge.points.emplace_back(from.x + side * from.width / 2, from.y);
+            edge.points.emplace_back(to.x - side * to.width / 2, to.y);
+        } else {
+            double side = to.layer > from.layer ? 1.0 : -1.0;
+            edge.points.emplace_back(from.x, from.y + side * from.height / 2);
+            for (uint32_t dummy : chains[c]) edge.points.emplace_back(x[dummy], layout.layerY[itemLayer[dummy]]);
+            edge.points.emplace_back(to.x, to.y - side * to.height / 2);
+        }
+        layout.edges.push_back(std::move(edge));
+    }
+    return layout;
+}
+
+namespace tree_layout_detail {
+
+inline std::string escapeXml(std::string_view text) {
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '&': escaped += "&amp;"; break;
+            case '<': escaped += "&lt;"; break;
+            case '>': escaped += "&gt;"; break;
+            case '"': escaped += "&quot;"; break;
+            default: escaped += c;
+        }
+    }
+    return escaped;
+}
+
+inline std::string escapeJson(std::string_view text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+}  // namespace tree_layout_detail
+
+// The drawing graph_bfs's DOT file gives: boxes with the wrapped titles, the root filled light
+// blue with a double border, arrows from each paper to the papers it cites, years on the left.
+inline void writeTreeSvg(const TreeLayout& layout, std::ostream& out, const TreeLayoutOptions& options = TreeLayoutOptions()) {
+    using tree_layout_detail::escapeXml;
+    out << std::fixed << std::setprecision(1);
+    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"" << layout.width << "\" height=\"" << layout.height
+        << "\" viewBox=\"0 0 " << layout.width << " " << layout.height
+        << "\" font-family=\"Helvetica,Arial,sans-serif\" font-size=\"12\">\n";
+    out << "<defs><marker id=\"arrow\" viewBox=\"0 0 10 10\" refX=\"10\" refY=\"5\" markerWidth=\"7\" markerHeight=\"7\" "
+           "orient=\"auto\"><path d=\"M0,0 L10,5 L0,10 z\" fill=\"#444\"/></marker></defs>\n";
+    out << "<rect width=\"100%\" height=\"100%\" fill=\"white\"/>\n";
+    for (size_t l = 0; l < layout.years.size(); ++l) {
+        out << "<text x=\"" << options.axisWidth / 2 << "\" y=\"" << layout.layerY[l] << "\" font-size=\"16\" text-anchor=\"middle\" "
+            << "dominant-baseline=\"central\">" << layout.years[l] << "</text>\n";
+    }
+    for (const LayoutEdge& edge : layout.edges) {
+        out << "<polyline fill=\"none\" stroke=\"#444\" marker-end=\"url(#arrow)\" points=\"";
+        for (size_t i = 0; i < edge.points.size(); ++i) out << (i > 0 ? " " : "") << edge.points[i].first << "," << edge.points[i].second;
+        out << "\"/>\n";
+    }
+    for (size_t i = 0; i < layout.nodes.size(); ++i) {
+        const LayoutNode& node = layout.nodes[i];
+        double left = node.x - node.width / 2, top = node.y - node.height / 2;
+        out << "<g id=\"paper-" << node.vertex << "\">";
+        out << "<rect x=\"" << left << "\" y=\"" << top << "\" width=\"" << node.width << "\" height=\"" << node.height << "\" fill=\""
+            << (i == 0 ? "lightblue" : "white") << "\" stroke=\"black\"/>";
+        if (i == 0) {
+            out << "<rect x=\"" << left + 3 << "\" y=\"" << top + 3 << "\" width=\"" << node.width - 6 << "\" height=\"" << node.height - 6
+                << "\" fill=\"none\" stroke=\"black\"/>";
+        }
+        out << "<text text-anchor=\"middle\">";
+        for (size_t k = 0; k < node.lines.size(); ++k) {
+            out << "<tspan x=\"" << node.x << "\" y=\"" << top + options.padding + (k + 0.8) * options.lineHeight << "\">"
+                << escapeXml(node.lines[k]) << "</tspan>";
+        }
+        out << "</text></g>\n";
+    }
+    out << "</svg>\n";
+}
+
+// Coordinates for a client-side renderer: nodes (vertex, year, center, size, label lines) in BFS
+// order and edges as point lists, in the SVG's pixels
+inline void writeTreeJson(const TreeLayout& layout, std::ostream& out) {
+    using tree_layout_detail::escapeJson;
+    out << std::fixed << std::setprecision(1);
+    out << "{\"width\":" << layout.width << ",\"height\":" << layout.height << ",\"crossings\":" << layout.crossings << ",\"layers\":[";
+    for (size_t l = 0; l < layout.years.size(); ++l) {
+        out << (l > 0 ? "," : "") << "{\"year\":" << layout.years[l] << ",\"y\":" << layout.layerY[l] << "}";
+    }
+    out << "],\"nodes\":[";
+    for (size_t i = 0; i < layout.nodes.size(); ++i) {
+        const LayoutNode& node = layout.nodes[i];
+        out << (i > 0 ? "," : "") << "\n{\"id\":" << node.vertex << ",\"year\":" << layout.years[node.layer] << ",\"x\":" << node.x
+            << ",\"y\":" << node.y << ",\"width\":" << node.width << ",\"height\":" << node.height << ",\"lines\":[";
+        for (size_t k = 0; k < node.lines.size(); ++k) out << (k > 0 ? "," : "") << "\"" << escapeJson(node.lines[k]) << "\"";
+        out << "]}";
+    }
+    out << "],\"edges\":[";
+    for (size_t e = 0; e < layout.edges.size(); ++e) {
+        const LayoutEdge& edge = layout.edges[e];
+        out << (e > 0 ? "," : "") << "\n{\"source\":" << layout.nodes[edge.parent].vertex << ",\"target\":" << layout.nodes[edge.child].vertex
+            << ",\"points\":[";
+        for (size_t i = 0; i < edge.points.size(); ++i) {
+            out << (i > 0 ? "," : "") << "[" << edge.points[i].first << "," << edge.points[i].second << "]";
+        }
+        out << "]}";
+    }
+    out << "]}\n";
+}
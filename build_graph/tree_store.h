@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bfs_tree.h"
+#include "graph_snapshot.h"
+#include "mapped_file.h"
+
+// Precomputed BFS trees in one memory-mapped file, written by precompute_trees and read by
+// graph_server, instead of one DOT file per tree under data/bfs_trees/.
+//
+// Layout: TreeStoreHeader, TreeStoreEntry[numTrees] sorted by root, then the vertices of all
+// trees (uint32_t[numVertices], each tree in BFS order) and for every vertex the position of
+// its parent within its tree (uint32_t[numVertices]; the root points at itself). Levels are
+// not stored, they follow from the parents. The header records the snapshot the trees were
+// built from and the depth and fan-out they were built with.
+
+const char kTreeStoreMagic[8] = {'P', 'V', 'T', 'R', 'E', 'E', 'S', '\0'};
+const uint32_t kTreeStoreVersion = 1;
+
+struct TreeStoreHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t numTrees;
+    uint64_t snapshotId;  // of the graph the trees come from
+    uint64_t storeId;     // changes whenever the store is rewritten
+    uint64_t numVertices;
+    int32_t depth;
+    uint32_t fanOut;      // TreeFanOut of the trees
+    uint32_t ranking;
+    uint32_t reserved;
+    uint64_t seed;
+};
+
+struct TreeStoreEntry {
+    uint32_t root;
+    uint32_t count;
+    uint64_t offset;  // of the root in the vertex array
+};
+
+// trees[i] must be the tree of roots[i]; every tree is stored in full.
+inline void writeTreeStore(const std::string& filename, uint64_t snapshotId, int depth, const TreeFanOut& fanOut,
+                           const std::vector<uint32_t>& roots, const std::vector<BfsTree>& trees) {
+    std::vector<size_t> order(roots.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return roots[a] < roots[b]; });
+
+    TreeStoreHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kTreeStoreMagic, sizeof(kTreeStoreMagic));
+    header.version = kTreeStoreVersion;
+    header.numTrees = static_cast<uint32_t>(roots.size());
+    header.snapshotId = snapshotId;
+    header.storeId = newSnapshotId();
+    header.depth = depth;
+    header.fanOut = fanOut.limit;
+    header.ranking = static_cast<uint32_t>(fanOut.ranking);
+    header.seed = fanOut.seed;
+
+    std::vector<TreeStoreEntry> entries;
+    for (size_t i : order) {
+        if (!entries.empty() && entries.back().root == roots[i]) throw std::runtime_error("Duplicate tree root");
+        entries.push_back(TreeStoreEntry{roots[i], static_cast<uint32_t>(trees[i].vertices.size()), header.numVertices});
+        header.numVertices += trees[i].vertices.size();
+    }
+
+    replaceFile(filename, "tree store", [&](auto write) {
+        write(reinterpret_cast<const char*>(&header), sizeof(header));
+        write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(TreeStoreEntry));
+        for (size_t i : order) {
+            write(reinterpret_cast<const char*>(trees[i].vertices.data()), trees[i].vertices.size() * sizeof(uint32_t));
+        }
+        std::vector<uint32_t> parents;
+        for (size_t i : order) {
+            // Parent positions: the parents are expanded in BFS order, so a cursor finds each one
+            const BfsTree& tree = trees[i];
+            parents.assign(tree.vertices.size(), 0);
+            for (size_t v = 1, cursor = 0; v < tree.vertices.size(); ++v) {
+                while (tree.vertices[cursor] != tree.parents[v]) ++cursor;
+                parents[v] = static_cast<uint32_t>(cursor);
+            }
+            write(reinterpret_cast<const char*>(parents.data()), parents.size() * sizeof(uint32_t));
+        }
+    });
+}
+
+// Read side over the mapped file; empty when default constructed.
+class TreeStore {
+public:
+    TreeStore() = default;
+
+    static TreeStore open(const std::string& filename) {
+        TreeStore store;
+        store.file_ = MappedFile(filename);
+        const char* base = store.file_.data();
+        size_t size = store.file_.size();
+        if (size < sizeof(TreeStoreHeader) || std::memcmp(base, kTreeStoreMagic, sizeof(kTreeStoreMagic)) != 0) {
+            throw std::runtime_error("Not a tree store: " + filename);
+        }
+        store.header_ = reinterpret_cast<const TreeStoreHeader*>(base);
+        if (store.header_->version != kTreeStoreVersion) throw std::runtime_error("Unsupported tree store version in " + filename);
+        uint64_t trees = store.header_->numTrees;
+        uint64_t vertices = store.header_->numVertices;
+        if (sizeof(TreeStoreHeader) + trees * sizeof(TreeStoreEntry) + 2 * vertices * sizeof(uint32_t) != size) {
+            throw std::runtime_error("Truncated tree store: " + filename);
+        }
+        const char* entries = base + sizeof(TreeStoreHeader);
+        store.entries_ = ArrayView<TreeStoreEntry>(reinterpret_cast<const TreeStoreEntry*>(entries), trees);
+        const char* vertexData = entries + trees * sizeof(TreeStoreEntry);
+        store.vertices_ = ArrayView<uint32_t>(reinterpret_cast<const uint32_t*>(vertexData), vertices);
+        store.parents_ = ArrayView<uint32_t>(reinterpret_cast<const uint32_t*>(vertexData) + vertices, vertices);
+        return store;
+    }
+
+    // storeId of a tree store file without mapping it; 0 when it is not one
+    static uint64_t fileStoreId(const std::string& filename) {
+        std::ifstream in(filename, std::ios::binary);
+        TreeStoreHeader header;
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, kTreeStoreMagic, sizeof(kTreeStoreMagic)) != 0) {
+            return 0;
+        }
+        return header.storeId;
+    }
+
+    bool empty() const { return entries_.empty(); }
+    size_t numTrees() const { return entries_.size(); }
+    uint64_t numVertices() const { return vertices_.size(); }
+    uint64_t snapshotId() const { return header_ ? header_->snapshotId : 0; }
+    uint64_t storeId() const { return header_ ? header_->storeId : 0; }
+    int depth() const { return header_ ? header_->depth : 0; }
+    TreeFanOut fanOut() const {
+        TreeFanOut fanOut;
+        if (!header_) return fanOut;
+        fanOut.limit = header_->fanOut;
+        fanOut.ranking = static_cast<ChildRanking>(header_->ranking);
+        fanOut.seed = header_->seed;
+        return fanOut;
+    }
+
+    // Whether the tree of (root, maxLevels, fanOut) on graph is stored: a tree of fewer levels
+    // is the prefix of the stored one up to its last level. maxLevels < 0 means no limit.
+    bool covers(const GraphSnapshot& graph, uint32_t root, int maxLevels, const TreeFanOut& fanOut) const {
+        if (empty() || graph.snapshotId() != snapshotId()) return false;
+        if (depth() >= 0 && (maxLevels < 0 || maxLevels > depth())) return false;
+        TreeFanOut stored = this->fanOut();
+        if (stored.limit != fanOut.limit || stored.ranking != fanOut.ranking) return false;
+        if (fanOut.ranking == ChildRanking::Random && stored.seed != fanOut.seed) return false;
+        return find(root) != nullptr;
+    }
+
+    // The stored tree of root cut to maxLevels (< 0: all of it), as BfsTreeBuilder would build it
+    BfsTree tree(uint32_t root, int maxLevels) const {
+        BfsTree tree;
+        const TreeStoreEntry* entry = find(root);
+        if (!entry) return tree;
+        const uint32_t* vertices = vertices_.data() + entry->offset;
+        const uint32_t* parents = parents_.data() + entry->offset;
+        for (uint32_t i = 0; i < entry->count; ++i) {
+            uint32_t level = i == 0 ? 0 : tree.levels[parents[i]] + 1;
+            if (maxLevels >= 0 && level > static_cast<uint32_t>(maxLevels)) break;
+            tree.vertices.push_back(vertices[i]);
+            tree.parents.push_back(vertices[parents[i]]);
+            tree.levels.push_back(level);
+        }
+        return tree;
+    }
+
+private:
+    const TreeStoreEntry* find(uint32_t root) const {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), root,
+                                   [](const TreeStoreEntry& entry, uint32_t r) { return entry.root < r; });
+        return it != entries_.end() && it->root == root ? it : nullptr;
+    }
+
+    MappedFile file_;
+    const TreeStoreHeader* header_ = nullptr;
+    ArrayView<TreeStoreEntry> entries_;
+    ArrayView<uint32_t> vertices_;
+    ArrayView<uint32_t> parents_;
+};
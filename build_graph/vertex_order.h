@@ -0,0 +1,215 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "csr_graph.h"
+
+// Vertex numberings that put vertices read together next to each other, so PageRank and BFS
+// touch fewer cache lines of the per-vertex arrays. Every order is returned as newToOld:
+// order[newId] is the vertex's id before relabeling.
+//   Degree  most cited first, so the hot entries of the rank vector share cache lines
+//   Rcm     reverse Cuthill-McKee on the undirected graph: BFS layers, small bandwidth
+//   Gorder  greedy window order (Wei et al.): each next vertex shares the most citers and
+//           citations with the last few placed ones
+enum class VertexOrder { Original, Degree, Rcm, Gorder };
+
+inline const char* vertexOrderName(VertexOrder order) {
+    switch (order) {
+    case VertexOrder::Degree: return "degree";
+    case VertexOrder::Rcm: return "rcm";
+    case VertexOrder::Gorder: return "gorder";
+    default: return "original";
+    }
+}
+
+inline bool parseVertexOrder(const std::string& name, VertexOrder& order) {
+    for (VertexOrder candidate : {VertexOrder::Original, VertexOrder::Degree, VertexOrder::Rcm, VertexOrder::Gorder}) {
+        if (name == vertexOrderName(candidate)) {
+            order = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline std::vector<uint32_t> invertPermutation(const std::vector<uint32_t>& permutation) {
+    std::vector<uint32_t> inverse(permutation.size());
+    for (uint32_t i = 0; i < permutation.size(); ++i) inverse[permutation[i]] = i;
+    return inverse;
+}
+
+// By in-degree (times cited within the graph), ties by id.
+inline std::vector<uint32_t> degreeOrder(const CsrView& in) {
+    std::vector<uint32_t> order(in.numNodes);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return in.degree(a) > in.degree(b); });
+    return order;
+}
+
+// Cuthill-McKee treats citations as undirected: each component is walked breadth first from a
+// vertex of lowest degree, neighbors in order of increasing degree; the result is reversed.
+inline std::vector<uint32_t> rcmOrder(const CsrView& out, const CsrView& in) {
+    const uint32_t n = out.numNodes;
+    auto degree = [&](uint32_t v) { return out.degree(v) + in.degree(v); };
+    std::vector<uint32_t> byDegree(n);
+    std::iota(byDegree.begin(), byDegree.end(), 0u);
+    std::stable_sort(byDegree.begin(), byDegree.end(), [&](uint32_t a, uint32_t b) { return degree(a) < degree(b); });
+
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    std::vector<uint8_t> placed(n, 0);
+    std::vector<uint32_t> neighbors;
+    for (uint32_t root : byDegree) {
+        if (placed[root]) continue;
+        placed[root] = 1;
+        order.push_back(root);
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            uint32_t u = order[head];
+            neighbors.clear();
+            for (uint32_t v : out.neighborsOf(u)) {
+                if (!placed[v]) neighbors.push_back(v);
+            }
+            for (uint32_t v : in.neighborsOf(u)) {
+                if (!placed[v]) neighbors.push_back(v);
+            }
+            std::sort(neighbors.begin(), neighbors.end(), [&](uint32_t a, uint32_t b) {
+                return degree(a) != degree(b) ? degree(a) < degree(b) : a < b;
+            });
+            for (uint32_t v : neighbors) {
+                if (placed[v]) continue; // listed twice when the citation goes both ways
+                placed[v] = 1;
+                order.push_back(v);
+            }
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Gorder scores a candidate u against the window of the last `window` placed vertices: +1 for
+// every citation between u and a window vertex, +1 for every paper citing both (co-citation,
+// the reads one PageRank row makes together). Scores live in a bucket queue with O(1) updates.
+// Papers citing more than sqrt(N) others are left out of the co-citation term, as in the paper,
+// so a handful of surveys cannot make the order quadratic.
+inline std::vector<uint32_t> gorderOrder(const CsrView& out, const CsrView& in, unsigned window = 5) {
+    const uint32_t n = out.numNodes;
+    const uint32_t kNone = UINT32_MAX;
+    const uint32_t hubDegree = std::max<uint32_t>(16, static_cast<uint32_t>(std::sqrt(static_cast<double>(n))));
+    std::vector<uint32_t> score(n, 0);
+    std::vector<uint32_t> prev(n, kNone);
+    std::vector<uint32_t> next(n, kNone);
+    std::vector<uint32_t> head(1, kNone);
+    std::vector<uint8_t> placed(n, 0);
+    uint32_t top = 0;
+
+    auto unlink = [&](uint32_t v) {
+        if (prev[v] != kNone) next[prev[v]] = next[v]; else head[score[v]] = next[v];
+        if (next[v] != kNone) prev[next[v]] = prev[v];
+    };
+    auto link = [&](uint32_t v) {
+        if (score[v] >= head.size()) head.resize(score[v] + 1, kNone);
+        prev[v] = kNone;
+        next[v] = head[score[v]];
+        if (next[v] != kNone) prev[next[v]] = v;
+        head[score[v]] = v;
+        top = std::max(top, score[v]);
+    };
+    auto adjust = [&](uint32_t u, int delta) {
+        if (placed[u]) return;
+        unlink(u);
+        score[u] += delta;
+        link(u);
+    };
+    // Applies delta to everything sharing a citation or a citer with v
+    auto update = [&](uint32_t v, int delta) {
+        for (uint32_t u : out.neighborsOf(v)) adjust(u, delta);
+        for (uint32_t w : in.neighborsOf(v)) {
+            adjust(w, delta);
+            if (out.degree(w) > hubDegree) continue;
+            for (uint32_t u : out.neighborsOf(w)) {
+                if (u != v) adjust(u, delta);
+            }
+        }
+    };
+
+    // Highest ids are linked first, so ties pop lowest id first
+    for (uint32_t v = n; v-- > 0;) link(v);
+    std::vector<uint32_t> order;
+    order.reserve(n);
+    // Start from the most cited paper
+    uint32_t first = 0;
+    for (uint32_t v = 1; v < n; ++v) {
+        if (in.degree(v) > in.degree(first)) first = v;
+    }
+    for (uint32_t v = n > 0 ? first : kNone; v != kNone;) {
+        unlink(v);
+        placed[v] = 1;
+        order.push_back(v);
+        update(v, 1);
+        if (order.size() > window) update(order[order.size() - 1 - window], -1);
+
+        v = kNone;
+        while (order.size() < n) {
+            if (head[top] != kNone) {
+                v = head[top];
+                break;
+            }
+            --top;
+        }
+    }
+    return order;
+}
+
+inline std::vector<uint32_t> computeVertexOrder(VertexOrder order, const CsrView& out, const CsrView& in) {
+    switch (order) {
+    case VertexOrder::Degree: return degreeOrder(in);
+    case VertexOrder::Rcm: return rcmOrder(out, in);
+    case VertexOrder::Gorder: return gorderOrder(out, in);
+    default: {
+        std::vector<uint32_t> identity(out.numNodes);
+        std::iota(identity.begin(), identity.end(), 0u);
+        return identity;
+    }
+    }
+}
+
+// The CSR relabeled by the permutation; rows stay sorted by (new) neighbor id.
+inline CsrGraph permuteCsr(const CsrView& csr, const std::vector<uint32_t>& newToOld, const std::vector<uint32_t>& oldToNew) {
+    CsrGraph permuted;
+    permuted.offsets.assign(csr.numNodes + 1, 0);
+    permuted.neighbors.resize(csr.numEdges());
+    for (uint32_t v = 0; v < csr.numNodes; ++v) {
+        uint32_t old = newToOld[v];
+        uint64_t begin = permuted.offsets[v];
+        uint64_t end = begin;
+        for (uint32_t u : csr.neighborsOf(old)) permuted.neighbors[end++] = oldToNew[u];
+        std::sort(permuted.neighbors.begin() + begin, permuted.neighbors.begin() + end);
+        permuted.offsets[v + 1] = end;
+    }
+    return permuted;
+}
+
+template <typename Values>
+auto permuteValues(const Values& values, const std::vector<uint32_t>& newToOld)
+    -> std::vector<typename std::decay<decltype(values[0])>::type> {
+    std::vector<typename std::decay<decltype(values[0])>::type> permuted;
+    permuted.reserve(newToOld.size());
+    for (uint32_t old : newToOld) permuted.push_back(values[old]);
+    return permuted;
+}
+
+// Mean log2 of the id distance along edges, a cache-size independent measure of locality
+// (0 would be every edge between neighbors in the numbering).
+inline double meanLogEdgeGap(const CsrView& csr) {
+    double sum = 0.0;
+    for (uint32_t v = 0; v < csr.numNodes; ++v) {
+        for (uint32_t u : csr.neighborsOf(v)) sum += std::log2(1.0 + (u > v ? u - v : v - u));
+    }
+    return csr.numEdges() == 0 ? 0.0 : sum / csr.numEdges();
+}
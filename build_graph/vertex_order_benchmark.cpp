@@ -0,0 +1,155 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "dot_graph_loader.h"
+#include "pagerank_engine.h"
+#include "vertex_order.h"
+
+// Relabels a graph with each vertex order and times the three access patterns the tools have:
+// PageRank (main.cpp's variant), BFS over the citers of a paper (derived works) and shortest
+// path queries over the citations. Sources and query pairs are the same papers in every order.
+
+struct Timings {
+    double pageRankMs = 0.0;
+    double bfsMs = 0.0;
+    double pathMs = 0.0;
+    uint64_t checksum = 0;  // visited counts and path lengths, equal across orders
+};
+
+template <typename Fn>
+double bestOf(int repeats, Fn fn) {
+    double best = 0.0;
+    for (int r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (r == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+// Breadth first from source; stops at target when there is one. Returns the vertices reached,
+// or the hop count to target (0 when unreachable). level is all UINT32_MAX on entry and exit.
+uint64_t bfs(const CsrView& graph, uint32_t source, uint32_t target, std::vector<uint32_t>& level,
+             std::vector<uint32_t>& queue) {
+    queue.clear();
+    queue.push_back(source);
+    level[source] = 0;
+    uint64_t found = 0;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t u = queue[head];
+        if (u == target) {
+            found = level[u];
+            break;
+        }
+        for (uint32_t v : graph.neighborsOf(u)) {
+            if (level[v] != UINT32_MAX) continue;
+            level[v] = level[u] + 1;
+            queue.push_back(v);
+        }
+    }
+    for (uint32_t v : queue) level[v] = UINT32_MAX;
+    return target == UINT32_MAX ? queue.size() : found;
+}
+
+Timings measure(const CsrView& out, const CsrView& in, const std::vector<int>& citationCounts,
+                const std::vector<uint32_t>& sources, const std::vector<std::pair<uint32_t, uint32_t>>& pairs,
+                unsigned threads, int repeats) {
+    Timings timings;
+    PageRankOptions options;
+    options.danglingMass = 1e-9 * countZeroDegree(out);
+    PageRankEngine engine(out, threads);
+    timings.pageRankMs = bestOf(repeats, [&]() {
+        std::vector<double> ranks = citationBiasedRanks(citationCounts);
+        engine.run(ranks, options);
+    });
+
+    std::vector<uint32_t> level(out.numNodes, UINT32_MAX);
+    std::vector<uint32_t> queue;
+    queue.reserve(out.numNodes);
+    uint64_t bfsChecksum = 0;
+    timings.bfsMs = bestOf(repeats, [&]() {
+        bfsChecksum = 0;
+        for (uint32_t s : sources) bfsChecksum += bfs(in, s, UINT32_MAX, level, queue);
+    });
+    uint64_t pathChecksum = 0;
+    timings.pathMs = bestOf(repeats, [&]() {
+        pathChecksum = 0;
+        for (const auto& pair : pairs) pathChecksum += bfs(out, pair.first, pair.second, level, queue);
+    });
+    timings.checksum = bfsChecksum * 1000003 + pathChecksum;
+    return timings;
+}
+
+int main(int argc, char* argv[]) {
+    // g++ -std=c++17 -O2 -pthread -o vertex_order_benchmark vertex_order_benchmark.cpp
+    std::string graph_filename = argc > 1 ? argv[1] : "data/citation_network.snapshot";
+    int repeats = argc > 2 ? std::max(1, std::stoi(argv[2])) : 5;
+    size_t numQueries = argc > 3 ? std::stoul(argv[3]) : 256;
+    unsigned threads = defaultThreadCount();
+
+    GraphSnapshot graph;
+    try {
+        graph = openGraph(graph_filename);
+    } catch (const std::exception& e) {
+        std::cerr << "Error loading graph: " << e.what() << std::endl;
+        return 1;
+    }
+    const uint32_t n = graph.numNodes();
+    if (n == 0) {
+        std::cerr << "Empty graph: " << graph_filename << std::endl;
+        return 1;
+    }
+    std::vector<int> citationCounts(graph.citationCounts().begin(), graph.citationCounts().end());
+
+    // BFS sources are cited papers (they have derived works); path queries go from a citing paper
+    std::mt19937_64 rng(42);
+    std::vector<uint32_t> sources;
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    for (size_t attempt = 0; attempt < 100 * numQueries && (sources.size() < numQueries || pairs.size() < numQueries); ++attempt) {
+        uint32_t a = static_cast<uint32_t>(rng() % n);
+        uint32_t b = static_cast<uint32_t>(rng() % n);
+        if (sources.size() < numQueries && graph.inDegree(a) > 0) sources.push_back(a);
+        if (pairs.size() < numQueries && graph.outDegree(a) > 0 && graph.inDegree(b) > 0) pairs.emplace_back(a, b);
+    }
+
+    std::cout << graph_filename << ": " << n << " nodes, " << graph.numEdges() << " edges, " << sources.size()
+              << " BFS sources, " << pairs.size() << " path queries, best of " << repeats
+              << (graph.reordered() ? " (stored order is already a --reorder)" : "") << std::endl;
+    std::cout << "  order      build ms  log2 gap    PageRank ms           BFS ms          path ms" << std::endl;
+    Timings baseline;
+    for (VertexOrder order : {VertexOrder::Original, VertexOrder::Degree, VertexOrder::Rcm, VertexOrder::Gorder}) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<uint32_t> newToOld = computeVertexOrder(order, graph.out(), graph.in());
+        std::vector<uint32_t> oldToNew = invertPermutation(newToOld);
+        CsrGraph out = permuteCsr(graph.out(), newToOld, oldToNew);
+        CsrGraph in = permuteCsr(graph.in(), newToOld, oldToNew);
+        double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::vector<uint32_t> orderSources;
+        for (uint32_t s : sources) orderSources.push_back(oldToNew[s]);
+        std::vector<std::pair<uint32_t, uint32_t>> orderPairs;
+        for (const auto& pair : pairs) orderPairs.emplace_back(oldToNew[pair.first], oldToNew[pair.second]);
+        Timings timings = measure(out.view(), in.view(), permuteValues(citationCounts, newToOld), orderSources, orderPairs,
+                                  threads, repeats);
+        if (order == VertexOrder::Original) baseline = timings;
+
+        auto cell = [](double ms, double baselineMs) {
+            std::ostringstream text;
+            text << std::fixed << std::setprecision(2) << ms << " (" << baselineMs / ms << "x)";
+            return text.str();
+        };
+        std::cout << "  " << std::left << std::setw(9) << vertexOrderName(order) << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(10) << buildMs << std::setprecision(2) << std::setw(10)
+                  << meanLogEdgeGap(out.view()) << std::setw(15) << cell(timings.pageRankMs, baseline.pageRankMs)
+                  << std::setw(17) << cell(timings.bfsMs, baseline.bfsMs) << std::setw(17)
+                  << cell(timings.pathMs, baseline.pathMs)
+                  << (timings.checksum == baseline.checksum ? "" : "  results differ!") << std::endl;
+    }
+    return 0;
+}